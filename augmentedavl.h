@@ -0,0 +1,449 @@
+#ifndef AUGMENTEDAVL_H
+#define AUGMENTEDAVL_H
+
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+#include <limits>
+#include <algorithm>
+#include "avlbst.h"
+
+/**
+* Monoids for AugmentedAVLTree. A monoid supplies
+*   typedef ... Type;                      the aggregate type
+*   static Type identity();                the aggregate of nothing
+*   static Type lift(const Item& item);    one (key, value) pair as an aggregate
+*   static Type combine(const Type& a, const Type& b);
+* where combine is associative and identity is neutral on both sides. The
+* provided monoids lift the value; lifting the whole item lets a monoid
+* aggregate something derived from the key instead (see IntervalTree).
+* combine is always called with the smaller keys on the left, so it need
+* not be commutative.
+*/
+template <typename T>
+struct SumMonoid
+{
+    typedef T Type;
+    static T identity() { return T(); }
+    template <typename Item>
+    static T lift(const Item& item) { return T(item.second); }
+    static T combine(const T& a, const T& b) { return a + b; }
+};
+
+template <typename T>
+struct MinMonoid
+{
+    typedef T Type;
+    static T identity() { return std::numeric_limits<T>::max(); }
+    template <typename Item>
+    static T lift(const Item& item) { return T(item.second); }
+    static T combine(const T& a, const T& b) { return std::min(a, b); }
+};
+
+template <typename T>
+struct MaxMonoid
+{
+    typedef T Type;
+    static T identity() { return std::numeric_limits<T>::lowest(); }
+    template <typename Item>
+    static T lift(const Item& item) { return T(item.second); }
+    static T combine(const T& a, const T& b) { return std::max(a, b); }
+};
+
+/**
+* An AVL node that also stores the aggregate of every value in its
+* subtree, itself included.
+*/
+template <typename Key, typename Value, typename T>
+class AugmentedAVLNode : public AVLNode<Key, Value>
+{
+public:
+    AugmentedAVLNode(const Key& key, const Value& value, const T& aggregate);
+    virtual ~AugmentedAVLNode();
+
+    const T& getAggregate() const;
+    void setAggregate(const T& aggregate);
+
+protected:
+    T aggregate_;
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the AugmentedAVLNode class.
+  -------------------------------------------------
+*/
+
+template<class Key, class Value, class T>
+AugmentedAVLNode<Key, Value, T>::AugmentedAVLNode(const Key& key, const Value& value, const T& aggregate) :
+    AVLNode<Key, Value>(key, value, nullptr), aggregate_(aggregate)
+{
+
+}
+
+template<class Key, class Value, class T>
+AugmentedAVLNode<Key, Value, T>::~AugmentedAVLNode()
+{
+
+}
+
+template<class Key, class Value, class T>
+const T& AugmentedAVLNode<Key, Value, T>::getAggregate() const
+{
+    return aggregate_;
+}
+
+template<class Key, class Value, class T>
+void AugmentedAVLNode<Key, Value, T>::setAggregate(const T& aggregate)
+{
+    aggregate_ = aggregate;
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the AugmentedAVLNode class.
+  -----------------------------------------------
+*/
+
+/**
+* An AVLTree that answers "combine every value with a key in [lo, hi)" in
+* O(log n) for any Monoid (see SumMonoid). Each node caches its subtree's
+* aggregate, and the tree keeps those caches current through its hooks:
+*   - nodeLinked and nodeUpdated refresh the path from the node to the root
+*     (before any rebalancing rotations, which then see correct children);
+*   - nodeRotated recomputes the two nodes a rotation moved, which is all a
+*     rotation changes;
+*   - removeNode refreshes the path from the unlinked node's parent once
+*     rebalancing is done. Every node whose subtree lost the item is on that
+*     path, including the ones removeFix rotated and the predecessor that
+*     nodeSwap moved up.
+*
+* buildSorted (and an endBulk into an empty tree) skips the path refresh
+* while it links, and recomputes every aggregate in one pass through
+* subtreeRebuilt instead.
+*
+* Values must only be changed through insert or update: writing through
+* operator[] or an iterator bypasses the caches.
+*/
+template <class Key, class Value, class Monoid = SumMonoid<Value> >
+class AugmentedAVLTree : public AVLTree<Key, Value>
+{
+public:
+    typedef typename Monoid::Type Aggregate;
+
+    AugmentedAVLTree();
+    AugmentedAVLTree(AugmentedAVLTree&& other) noexcept;
+    AugmentedAVLTree& operator=(AugmentedAVLTree&& other) noexcept;
+    template <class Tree, class = EnableIfDerivedTree<AugmentedAVLTree, Tree> >
+    AugmentedAVLTree(Tree&& other) = delete;
+    template <class Tree, class = EnableIfDerivedTree<AugmentedAVLTree, Tree> >
+    AugmentedAVLTree& operator=(Tree&& other) = delete;
+    void swap(AugmentedAVLTree& other) noexcept;
+    template <class Tree, class = EnableIfDerivedTree<AugmentedAVLTree, Tree> >
+    void swap(Tree& other) = delete;
+    void update(const Key& key, const Value& value);
+    Aggregate aggregate() const;
+    Aggregate aggregate(const Key& lo, const Key& hi) const;
+    AugmentedAVLTree clone() const;
+
+protected:
+    typedef AugmentedAVLNode<Key, Value, Aggregate> NodeType;
+
+    virtual AVLNode<Key, Value>* createNode(const Key& key, const Value& value);
+    virtual size_t nodeBytes() const;
+    virtual size_t treeBytes() const;
+    virtual Node<Key, Value>* cloneNode(const Node<Key, Value>* src);
+    virtual void nodeCloned(Node<Key, Value>* copy, const Node<Key, Value>* src);
+    virtual void nodeLinked(Node<Key, Value>* n);
+    virtual void nodeUnlinking(Node<Key, Value>* n);
+    virtual void nodeUpdated(Node<Key, Value>* n);
+    virtual void nodeRotated(AVLNode<Key, Value>* down);
+    virtual void subtreeRebuilt(AVLNode<Key, Value>* root);
+    virtual void removeNode(Node<Key, Value>* n);
+
+    Aggregate aggregateRange(const Key* lo, bool loInclusive, const Key* hi) const;
+    static bool belowRange(const Key& key, const Key* lo, bool loInclusive);
+    static Aggregate aggregateOf(Node<Key, Value>* n);
+    static void recompute(Node<Key, Value>* n);
+    static void recomputeSubtree(Node<Key, Value>* n);
+    static void refreshPath(Node<Key, Value>* n);
+
+    // parent of the node removeNode is about to unlink
+    Node<Key, Value>* refreshFrom_;
+};
+
+template<class Key, class Value, class Monoid>
+AugmentedAVLTree<Key, Value, Monoid>::AugmentedAVLTree() :
+    refreshFrom_(nullptr)
+{
+
+}
+
+/**
+* The aggregates live in the nodes, so they move with them.
+*/
+template<class Key, class Value, class Monoid>
+AugmentedAVLTree<Key, Value, Monoid>::AugmentedAVLTree(AugmentedAVLTree&& other) noexcept :
+    AVLTree<Key, Value>(static_cast<AVLTree<Key, Value>&&>(other)), refreshFrom_(nullptr)
+{
+
+}
+
+template<class Key, class Value, class Monoid>
+AugmentedAVLTree<Key, Value, Monoid>&
+AugmentedAVLTree<Key, Value, Monoid>::operator=(AugmentedAVLTree&& other) noexcept
+{
+    AugmentedAVLTree<Key, Value, Monoid> old(std::move(other));
+    swap(old);
+    return *this;
+}
+
+template<class Key, class Value, class Monoid>
+void AugmentedAVLTree<Key, Value, Monoid>::swap(AugmentedAVLTree& other) noexcept
+{
+    AVLTree<Key, Value>::swap(static_cast<AVLTree<Key, Value>&>(other));
+}
+
+template<class Key, class Value, class Monoid>
+AVLNode<Key, Value>* AugmentedAVLTree<Key, Value, Monoid>::createNode(const Key& key, const Value& value)
+{
+    //nodeLinked computes the real aggregate once the node is in place
+    return new NodeType(key, value, Monoid::identity());
+}
+
+template<class Key, class Value, class Monoid>
+size_t AugmentedAVLTree<Key, Value, Monoid>::nodeBytes() const
+{
+    return sizeof(NodeType);
+}
+
+template<class Key, class Value, class Monoid>
+size_t AugmentedAVLTree<Key, Value, Monoid>::treeBytes() const
+{
+    return sizeof(AugmentedAVLTree<Key, Value, Monoid>);
+}
+
+template<class Key, class Value, class Monoid>
+AugmentedAVLTree<Key, Value, Monoid> AugmentedAVLTree<Key, Value, Monoid>::clone() const
+{
+    AugmentedAVLTree<Key, Value, Monoid> copy;
+    copy.cloneFrom(*this);
+    return copy;
+}
+
+/**
+* Copies carry their original's aggregate, which covers the same items.
+*/
+template<class Key, class Value, class Monoid>
+Node<Key, Value>* AugmentedAVLTree<Key, Value, Monoid>::cloneNode(const Node<Key, Value>* src)
+{
+    Node<Key, Value>* copy = AVLTree<Key, Value>::cloneNode(src);
+    static_cast<NodeType*>(copy)->setAggregate(static_cast<const NodeType*>(src)->getAggregate());
+    return copy;
+}
+
+/**
+* Skips the path refresh nodeLinked would do, as every aggregate is
+* already right, keeping clone linear.
+*/
+template<class Key, class Value, class Monoid>
+void AugmentedAVLTree<Key, Value, Monoid>::nodeCloned(Node<Key, Value>* copy, const Node<Key, Value>* src)
+{
+    (void)src;
+    AVLTree<Key, Value>::nodeLinked(copy);
+}
+
+/**
+* Empty subtrees aggregate to the identity.
+*/
+template<class Key, class Value, class Monoid>
+typename AugmentedAVLTree<Key, Value, Monoid>::Aggregate
+AugmentedAVLTree<Key, Value, Monoid>::aggregateOf(Node<Key, Value>* n)
+{
+    return n == nullptr ? Monoid::identity() : static_cast<NodeType*>(n)->getAggregate();
+}
+
+template<class Key, class Value, class Monoid>
+void AugmentedAVLTree<Key, Value, Monoid>::recompute(Node<Key, Value>* n)
+{
+    static_cast<NodeType*>(n)->setAggregate(
+        Monoid::combine(Monoid::combine(aggregateOf(n->getLeft()), Monoid::lift(n->getItem())),
+                        aggregateOf(n->getRight())));
+}
+
+template<class Key, class Value, class Monoid>
+void AugmentedAVLTree<Key, Value, Monoid>::refreshPath(Node<Key, Value>* n)
+{
+    for ( ; n != nullptr; n = n->getParent()){
+      recompute(n);
+    }
+}
+
+/**
+* A new node is a leaf; while linkSorted relinks, subtreeRebuilt refreshes
+* the path above it later.
+*/
+template<class Key, class Value, class Monoid>
+void AugmentedAVLTree<Key, Value, Monoid>::nodeLinked(Node<Key, Value>* n)
+{
+    AVLTree<Key, Value>::nodeLinked(n);
+    if (this->relinking_){
+      recompute(n);
+    }
+    else {
+      refreshPath(n);
+    }
+}
+
+template<class Key, class Value, class Monoid>
+void AugmentedAVLTree<Key, Value, Monoid>::nodeUnlinking(Node<Key, Value>* n)
+{
+    AVLTree<Key, Value>::nodeUnlinking(n);
+    refreshFrom_ = n->getParent();
+}
+
+template<class Key, class Value, class Monoid>
+void AugmentedAVLTree<Key, Value, Monoid>::nodeUpdated(Node<Key, Value>* n)
+{
+    AVLTree<Key, Value>::nodeUpdated(n);
+    refreshPath(n);
+}
+
+template<class Key, class Value, class Monoid>
+void AugmentedAVLTree<Key, Value, Monoid>::nodeRotated(AVLNode<Key, Value>* down)
+{
+    AVLTree<Key, Value>::nodeRotated(down);
+    recompute(down);
+    recompute(down->getParent());
+}
+
+/**
+* Rebuilt subtrees are balanced, so recursing is safe.
+*/
+template<class Key, class Value, class Monoid>
+void AugmentedAVLTree<Key, Value, Monoid>::recomputeSubtree(Node<Key, Value>* n)
+{
+    if (n == nullptr){
+      return;
+    }
+    recomputeSubtree(n->getLeft());
+    recomputeSubtree(n->getRight());
+    recompute(n);
+}
+
+template<class Key, class Value, class Monoid>
+void AugmentedAVLTree<Key, Value, Monoid>::subtreeRebuilt(AVLNode<Key, Value>* root)
+{
+    AVLTree<Key, Value>::subtreeRebuilt(root);
+    recomputeSubtree(root);
+}
+
+template<class Key, class Value, class Monoid>
+void AugmentedAVLTree<Key, Value, Monoid>::removeNode(Node<Key, Value>* n)
+{
+    refreshFrom_ = nullptr;
+    AVLTree<Key, Value>::removeNode(n);
+    refreshPath(refreshFrom_);
+    refreshFrom_ = nullptr;
+}
+
+/**
+* Overwrites the value stored under key and refreshes the aggregates on
+* its path. Throws std::out_of_range if the key is not in the tree. In
+* bulk mode the pending inserts are applied first, as remove does.
+*/
+template<class Key, class Value, class Monoid>
+void AugmentedAVLTree<Key, Value, Monoid>::update(const Key& key, const Value& value)
+{
+    this->applyBulk();
+    Node<Key, Value>* node = this->internalFind(key);
+    if (node == nullptr){
+      throw std::out_of_range("Invalid key");
+    }
+    node->setValue(value);
+    refreshPath(node);
+}
+
+/**
+* The aggregate of the whole tree, in O(1).
+*/
+template<class Key, class Value, class Monoid>
+typename AugmentedAVLTree<Key, Value, Monoid>::Aggregate
+AugmentedAVLTree<Key, Value, Monoid>::aggregate() const
+{
+    return aggregateOf(this->root_);
+}
+
+/**
+* The aggregate of the values with keys in [lo, hi), in O(log n).
+*/
+template<class Key, class Value, class Monoid>
+typename AugmentedAVLTree<Key, Value, Monoid>::Aggregate
+AugmentedAVLTree<Key, Value, Monoid>::aggregate(const Key& lo, const Key& hi) const
+{
+    return aggregateRange(&lo, true, &hi);
+}
+
+template<class Key, class Value, class Monoid>
+bool AugmentedAVLTree<Key, Value, Monoid>::belowRange(const Key& key, const Key* lo, bool loInclusive)
+{
+    return lo != nullptr && (loInclusive ? key < *lo : !(*lo < key));
+}
+
+/**
+* The aggregate of the keys between lo and hi: lo is inclusive or exclusive
+* as asked, hi always exclusive, and a null bound is unbounded. Descends
+* to the first node inside the range (where the paths to lo and hi split),
+* then follows each boundary down once: on the lo side every node in range
+* contributes itself plus its whole right subtree, on the hi side itself
+* plus its whole left subtree.
+*/
+template<class Key, class Value, class Monoid>
+typename AugmentedAVLTree<Key, Value, Monoid>::Aggregate
+AugmentedAVLTree<Key, Value, Monoid>::aggregateRange(const Key* lo, bool loInclusive, const Key* hi) const
+{
+    Node<Key, Value>* split = this->root_;
+    while (split != nullptr){
+      if (belowRange(split->getKey(), lo, loInclusive)){
+        split = split->getRight();
+      }
+      else if (hi != nullptr && !(split->getKey() < *hi)){
+        split = split->getLeft();
+      }
+      else {
+        break;
+      }
+    }
+    if (split == nullptr){
+      return Monoid::identity();
+    }
+
+    //lower side: found in decreasing key order, so each piece goes in front
+    Aggregate lower = Monoid::identity();
+    for (Node<Key, Value>* n = split->getLeft(); n != nullptr; ){
+      if (belowRange(n->getKey(), lo, loInclusive)){
+        n = n->getRight();
+      }
+      else {
+        lower = Monoid::combine(Monoid::combine(Monoid::lift(n->getItem()), aggregateOf(n->getRight())), lower);
+        n = n->getLeft();
+      }
+    }
+
+    //upper side: found in increasing key order
+    Aggregate upper = Monoid::identity();
+    for (Node<Key, Value>* n = split->getRight(); n != nullptr; ){
+      if (hi != nullptr && !(n->getKey() < *hi)){
+        n = n->getLeft();
+      }
+      else {
+        upper = Monoid::combine(upper, Monoid::combine(aggregateOf(n->getLeft()), Monoid::lift(n->getItem())));
+        n = n->getRight();
+      }
+    }
+
+    return Monoid::combine(Monoid::combine(lower, Monoid::lift(split->getItem())), upper);
+}
+
+#endif
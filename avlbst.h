@@ -3,9 +3,11 @@
 
 #include <iostream>
 #include <exception>
+#include <stdexcept>
 #include <cstdlib>
 #include <cstdint>
 #include <algorithm>
+#include <vector>
 #include "bst.h"
 
 struct KeyError { };
@@ -131,44 +133,208 @@ template <class Key, class Value>
 class AVLTree : public BinarySearchTree<Key, Value>
 {
 public:
+    typedef typename BinarySearchTree<Key, Value>::iterator iterator;
+
+    AVLTree();
+    AVLTree(AVLTree&& other) noexcept;
+    AVLTree& operator=(AVLTree&& other) noexcept;
+    template <class Tree, class = EnableIfDerivedTree<AVLTree, Tree> >
+    AVLTree(Tree&& other) = delete;
+    template <class Tree, class = EnableIfDerivedTree<AVLTree, Tree> >
+    AVLTree& operator=(Tree&& other) = delete;
+    void swap(AVLTree& other) noexcept;
+    template <class Tree, class = EnableIfDerivedTree<AVLTree, Tree> >
+    void swap(Tree& other) = delete;
+    AVLTree clone() const;
     virtual void insert (const std::pair<const Key, Value> &new_item); // TODO
+    iterator insert(iterator hint, const std::pair<const Key, Value> &new_item);
+    iterator emplace_hint(iterator hint, const Key& key, const Value& value);
+    void buildSorted(const std::pair<const Key, Value>* items, size_t count);
     virtual void remove(const Key& key);  // TODO
+    virtual void clear();
+    void beginBulk();
+    void endBulk();
+    bool inBulk() const;
+    TreeCheckResult validate(unsigned checks = CHECK_ORDER | CHECK_HEIGHT_BALANCE | CHECK_BALANCE_FIELD) const;
+    TreeCheckResult validate(unsigned checks, WorkStealingPool& pool) const;
+    void exportTree(std::ostream& out, TreeExportFormat format = EXPORT_DOT,
+                    const TreeExportOptions& options = TreeExportOptions()) const;
 protected:
     virtual void nodeSwap( AVLNode<Key,Value>* n1, AVLNode<Key,Value>* n2);
+    virtual void removeNode(Node<Key, Value>* n);
+
+    virtual AVLNode<Key, Value>* createNode(const Key& key, const Value& value);
+    virtual size_t nodeBytes() const;
+    virtual size_t treeBytes() const;
+    virtual void cloneFrom(const BinarySearchTree<Key, Value>& src);
+    virtual Node<Key, Value>* cloneNode(const Node<Key, Value>* src);
+    AVLNode<Key, Value>* insertNode(const Key& key, const Value& value);
+    void linkNode(AVLNode<Key, Value>* parent, AVLNode<Key, Value>* node);
+    AVLNode<Key, Value>* hintedParent(AVLNode<Key, Value>* next, const Key& key,
+                                      AVLNode<Key, Value>*& found) const;
 
     // Add helper functions here
     void rotateLeft(AVLNode<Key,Value>* n);
     void rotateRight(AVLNode<Key, Value>* n);
+    // called at the end of each rotation with the node that moved down;
+    // its old child is now its parent
+    virtual void nodeRotated(AVLNode<Key, Value>* down);
 
     void insertFix(AVLNode<Key,Value>* p, AVLNode<Key,Value>* n); 
     void removeFix(AVLNode<Key, Value>* node, int diff);
+    static bool balanceMatches(const AVLNode<Key, Value>* node, int diff);
+    static int nodeBalance(const AVLNode<Key, Value>* node);
 
+    template<class Item>
+    void linkSorted(const Item* items, size_t count);
+    void applyBulk();
+    // called by linkSorted with the root of the tree it built, whose nodes
+    // nodeLinked saw while relinking_ was set
+    virtual void subtreeRebuilt(AVLNode<Key, Value>* root);
 
+    // last inserted node, tried as a second hint when the caller's is wrong
+    AVLNode<Key, Value>* finger_;
+    bool bulk_;
+    // inserts made in bulk mode, in arrival order, until applyBulk
+    std::vector<std::pair<Key, Value> > bulkItems_;
+    // set while linkSorted links nodes, so link hooks can skip per-path work
+    bool relinking_;
 };
 
+template<class Key, class Value>
+AVLTree<Key, Value>::AVLTree() :
+  finger_(nullptr), bulk_(false), relinking_(false)
+{
+
+}
+
+/**
+* Takes over other's nodes and pending bulk inserts in O(1), leaving other
+* empty and out of bulk mode.
+*/
+template<class Key, class Value>
+AVLTree<Key, Value>::AVLTree(AVLTree&& other) noexcept :
+  BinarySearchTree<Key, Value>(static_cast<BinarySearchTree<Key, Value>&&>(other)),
+  finger_(other.finger_), bulk_(other.bulk_), bulkItems_(std::move(other.bulkItems_)),
+  relinking_(false)
+{
+    other.finger_ = nullptr;
+    other.bulk_ = false;
+}
+
+template<class Key, class Value>
+AVLTree<Key, Value>& AVLTree<Key, Value>::operator=(AVLTree&& other) noexcept
+{
+    AVLTree<Key, Value> old(std::move(other));
+    swap(old);
+    return *this;
+}
+
+template<class Key, class Value>
+void AVLTree<Key, Value>::swap(AVLTree& other) noexcept
+{
+    BinarySearchTree<Key, Value>::swap(static_cast<BinarySearchTree<Key, Value>&>(other));
+    std::swap(finger_, other.finger_);
+    std::swap(bulk_, other.bulk_);
+    bulkItems_.swap(other.bulkItems_);
+}
+
+/**
+* Copies the shape and every balance_ as they are, so the copy needs no
+* rotations (and a copy taken in bulk mode is in bulk mode too, with the
+* same inserts pending).
+*/
+template<class Key, class Value>
+AVLTree<Key, Value> AVLTree<Key, Value>::clone() const
+{
+    AVLTree<Key, Value> copy;
+    copy.cloneFrom(*this);
+    return copy;
+}
+
+template<class Key, class Value>
+void AVLTree<Key, Value>::cloneFrom(const BinarySearchTree<Key, Value>& src)
+{
+    BinarySearchTree<Key, Value>::cloneFrom(src);
+    const AVLTree<Key, Value>& tree = static_cast<const AVLTree<Key, Value>&>(src);
+    bulk_ = tree.bulk_;
+    bulkItems_ = tree.bulkItems_;
+}
+
+/**
+* Goes through createNode, so derived trees get their own node type.
+*/
+template<class Key, class Value>
+Node<Key, Value>* AVLTree<Key, Value>::cloneNode(const Node<Key, Value>* src)
+{
+    AVLNode<Key, Value>* copy = createNode(src->getKey(), src->getValue());
+    copy->setBalance(static_cast<const AVLNode<Key, Value>*>(src)->getBalance());
+    return copy;
+}
+
+/**
+* Allocates a new, unlinked node. Trees with richer node types override this.
+*/
+template<class Key, class Value>
+AVLNode<Key, Value>* AVLTree<Key, Value>::createNode(const Key& key, const Value& value)
+{
+    return new AVLNode<Key, Value>(key, value, nullptr);
+}
+
+/**
+* Must agree with createNode.
+*/
+template<class Key, class Value>
+size_t AVLTree<Key, Value>::nodeBytes() const
+{
+    return sizeof(AVLNode<Key, Value>);
+}
+
+template<class Key, class Value>
+size_t AVLTree<Key, Value>::treeBytes() const
+{
+    return sizeof(AVLTree<Key, Value>);
+}
+
 /*
  * Recall: If key is already in the tree, you should 
  * overwrite the current value with the updated value.
  */
 template<class Key, class Value>
 void AVLTree<Key, Value>::insert (const std::pair<const Key, Value> &new_item)
+{
+    if (bulk_){
+      bulkItems_.push_back(std::pair<Key, Value>(new_item.first, new_item.second));
+      return;
+    }
+    insertNode(new_item.first, new_item.second);
+}
+
+/**
+* Descends from the root and inserts (or overwrites) key's value,
+* returning the node that now holds it.
+*/
+template<class Key, class Value>
+AVLNode<Key, Value>* AVLTree<Key, Value>::insertNode (const Key& key, const Value& value)
 {
     // TODO
     /*
     pseudocode
-    - look at key of new_item
-    - walk the tree to the correct node, and insert the newitem as its child
+    - look at key
+    - walk the tree to the correct node, and insert the new item as its child
     - look at parent p
     - if balance(p) = -1 or 1, set it to 0 (the balance of grandparent doesn't change)
     - if balance(p) = 0, call insertFix because the grandparent may now be unbalanced
     */
 
-    AVLNode<Key, Value>* node = new AVLNode<Key, Value>(new_item.first, new_item.second, nullptr);
+    AVLNode<Key, Value>* node = createNode(key, value);
     
     //empty tree case
     if (this->root_ == nullptr){
       this->root_ = node; 
-      return; 
+      this->nodeLinked(node);
+      finger_ = node;
+      return node; 
     }
 
     AVLNode<Key, Value>* current = static_cast<AVLNode<Key, Value>*>(this->root_);
@@ -185,13 +351,26 @@ void AVLTree<Key, Value>::insert (const std::pair<const Key, Value> &new_item)
       }
       else { //same key, so rewrite value
         current->setValue(node->getValue());
+        this->nodeUpdated(current);
         delete node; //deallocate
-        return; 
+        return current; 
       }
     }
 
     //after exiting from loop, right spot
+    linkNode(prev, node);
+    return node;
+}
+
+/**
+* Hangs node under prev (which must have a free slot on the side the key
+* belongs to) and restores the AVL balance.
+*/
+template<class Key, class Value>
+void AVLTree<Key, Value>::linkNode (AVLNode<Key, Value>* prev, AVLNode<Key, Value>* node)
+{
     //insert - update pointers
+    finger_ = node;
     node->setParent(prev);
     if (node->getKey() < prev->getKey()){
       prev->setLeft(node);
@@ -199,6 +378,7 @@ void AVLTree<Key, Value>::insert (const std::pair<const Key, Value> &new_item)
     else {
       prev->setRight(node);
     }
+    this->nodeLinked(node);
 
     //fix balance of the tree
     if (prev->getBalance() == -1){ 
@@ -219,6 +399,333 @@ void AVLTree<Key, Value>::insert (const std::pair<const Key, Value> &new_item)
 
 }
 
+/**
+* Returns the node that a key belonging immediately before next (nullptr
+* meaning end()) should hang under, or nullptr if the key does not fall
+* between next and its predecessor. If the key is equal to either
+* neighbour, that node is returned through found instead.
+*/
+template<class Key, class Value>
+AVLNode<Key, Value>* AVLTree<Key, Value>::hintedParent (AVLNode<Key, Value>* next, const Key& key,
+                                                         AVLNode<Key, Value>*& found) const
+{
+    if (next != nullptr && !(key < next->getKey())){
+      if (!(next->getKey() < key)){
+        found = next;
+      }
+      return nullptr;
+    }
+
+    AVLNode<Key, Value>* prev;
+    if (next == nullptr){
+      prev = static_cast<AVLNode<Key, Value>*>(this->getLargestNode());
+    }
+    else {
+      prev = static_cast<AVLNode<Key, Value>*>(this->predecessor(next));
+    }
+    if (prev != nullptr && !(prev->getKey() < key)){
+      if (!(key < prev->getKey())){
+        found = prev;
+      }
+      return nullptr;
+    }
+
+    //key fits between prev and next. either next has a free left slot,
+    //or prev is the rightmost node of next's left subtree
+    if (next != nullptr && next->getLeft() == nullptr){
+      return next;
+    }
+    return prev;
+}
+
+/**
+* Inserts new_item using hint as the position it should go before, as
+* with std::map. If the hint is wrong the successor of the last inserted
+* node is tried, and only if that fails too does the insert descend from
+* the root. Sorted or append-mostly streams that pass end() (or the
+* iterator returned by the previous call, advanced) skip the descent and
+* only pay for the amortized O(1) rebalancing. In bulk mode the pending
+* inserts are applied first, as the returned iterator needs a node.
+*/
+template<class Key, class Value>
+typename AVLTree<Key, Value>::iterator
+AVLTree<Key, Value>::insert (iterator hint, const std::pair<const Key, Value> &new_item)
+{
+    applyBulk();
+    if (this->root_ == nullptr){
+      return this->makeIterator(insertNode(new_item.first, new_item.second));
+    }
+
+    AVLNode<Key, Value>* found = nullptr;
+    AVLNode<Key, Value>* parent = hintedParent(
+        static_cast<AVLNode<Key, Value>*>(this->iteratorNode(hint)), new_item.first, found);
+
+    if (parent == nullptr && found == nullptr && finger_ != nullptr){
+      iterator afterFinger = this->makeIterator(finger_);
+      ++afterFinger;
+      parent = hintedParent(
+          static_cast<AVLNode<Key, Value>*>(this->iteratorNode(afterFinger)), new_item.first, found);
+    }
+
+    if (found != nullptr){ //same key, so rewrite value
+      found->setValue(new_item.second);
+      this->nodeUpdated(found);
+      return this->makeIterator(found);
+    }
+    if (parent == nullptr){ //both hints were wrong
+      return this->makeIterator(insertNode(new_item.first, new_item.second));
+    }
+
+    AVLNode<Key, Value>* node = createNode(new_item.first, new_item.second);
+    linkNode(parent, node);
+    return this->makeIterator(node);
+}
+
+/**
+* Same as the hinted insert but takes the key and value separately.
+*/
+template<class Key, class Value>
+typename AVLTree<Key, Value>::iterator
+AVLTree<Key, Value>::emplace_hint (iterator hint, const Key& key, const Value& value)
+{
+    return insert(hint, std::make_pair(key, value));
+}
+
+/**
+* Same as BinarySearchTree::validate, but also able to check that each
+* node's stored balance agrees with its subtree heights.
+*/
+template<class Key, class Value>
+TreeCheckResult AVLTree<Key, Value>::validate (unsigned checks) const
+{
+    return validate(checks, WorkStealingPool::shared());
+}
+
+template<class Key, class Value>
+TreeCheckResult AVLTree<Key, Value>::validate (unsigned checks, WorkStealingPool& pool) const
+{
+    TreeChecker<AVLNode<Key, Value>, Key> checker(checks, &AVLTree<Key, Value>::balanceMatches);
+    return checker.run(static_cast<AVLNode<Key, Value>*>(this->root_), pool);
+}
+
+template<class Key, class Value>
+bool AVLTree<Key, Value>::balanceMatches (const AVLNode<Key, Value>* node, int diff)
+{
+    return node->getBalance() == diff;
+}
+
+/**
+* Same as BinarySearchTree::exportTree, with each node's balance_ included.
+*/
+template<class Key, class Value>
+void AVLTree<Key, Value>::exportTree (std::ostream& out, TreeExportFormat format,
+                                      const TreeExportOptions& options) const
+{
+    TreeExporter<AVLNode<Key, Value> > exporter(options, &AVLTree<Key, Value>::nodeBalance);
+    exporter.run(static_cast<AVLNode<Key, Value>*>(this->root_), out, format);
+}
+
+template<class Key, class Value>
+int AVLTree<Key, Value>::nodeBalance (const AVLNode<Key, Value>* node)
+{
+    return node->getBalance();
+}
+
+/**
+* Replaces the contents with count items whose keys are strictly
+* increasing, in O(n) instead of O(n log n) inserts. Throws
+* std::invalid_argument, leaving the tree untouched, if the keys are out
+* of order. Inserts pending in bulk mode go along with the old contents.
+*/
+template<class Key, class Value>
+void AVLTree<Key, Value>::buildSorted (const std::pair<const Key, Value>* items, size_t count)
+{
+    for (size_t i = 1; i < count; i++){
+      if (!(items[i - 1].first < items[i].first)){
+        throw std::invalid_argument("Keys not strictly increasing");
+      }
+    }
+    clear();
+    linkSorted(items, count);
+}
+
+/**
+* Links count items with strictly increasing keys into the empty tree.
+*
+* Each range's middle item becomes the subtree root, with the extra item
+* of an even range going left, so a range of s items has height
+* bitlength(s) and every balance is known up front. Nodes are linked in
+* pre-order, so each one is a leaf when nodeLinked sees it, as after an
+* ordinary insert, and no rotations are needed. The links happen with
+* relinking_ set, so trees that cache per-subtree state do not walk to
+* the root for each one; subtreeRebuilt then settles the whole tree in
+* one pass.
+*/
+template<class Key, class Value>
+template<class Item>
+void AVLTree<Key, Value>::linkSorted (const Item* items, size_t count)
+{
+    struct Range
+    {
+        AVLNode<Key, Value>* parent;
+        size_t lo;
+        size_t hi;      // exclusive
+    };
+    auto height = [](size_t s) {
+      int h = 0;
+      for ( ; s != 0; s >>= 1){
+        h++;
+      }
+      return h;
+    };
+
+    std::vector<Range> stack;
+    if (count > 0){
+      Range all = { nullptr, 0, count };
+      stack.push_back(all);
+    }
+    relinking_ = true;
+    while (!stack.empty()){
+      Range range = stack.back();
+      stack.pop_back();
+      size_t leftSize = (range.hi - range.lo) / 2;
+      size_t mid = range.lo + leftSize;
+      AVLNode<Key, Value>* node = createNode(items[mid].first, items[mid].second);
+      node->setBalance((int8_t)(height(range.hi - mid - 1) - height(leftSize)));
+      node->setParent(range.parent);
+      if (range.parent == nullptr){
+        this->root_ = node;
+      }
+      else if (node->getKey() < range.parent->getKey()){
+        range.parent->setLeft(node);
+      }
+      else {
+        range.parent->setRight(node);
+      }
+      this->nodeLinked(node);
+
+      if (mid + 1 < range.hi){
+        Range right = { node, mid + 1, range.hi };
+        stack.push_back(right);
+      }
+      if (range.lo < mid){
+        Range left = { node, range.lo, mid };
+        stack.push_back(left);
+      }
+    }
+    relinking_ = false;
+    if (this->root_ != nullptr){
+      subtreeRebuilt(static_cast<AVLNode<Key, Value>*>(this->root_));
+    }
+}
+
+/**
+* Removes everything, dropping the insertion finger and any inserts
+* pending in bulk mode along with the nodes.
+*/
+template<class Key, class Value>
+void AVLTree<Key, Value>::clear ()
+{
+    finger_ = nullptr;
+    bulkItems_.clear();
+    BinarySearchTree<Key, Value>::clear();
+}
+
+/**
+* Starts a bulk load: until endBulk, insert only appends the item to a
+* buffer, and endBulk applies the whole buffer in key order. Until then
+* the buffered items are invisible: lookups, iteration and the pops see
+* the tree as it was, which stays a valid AVL tree. remove and the hinted
+* insert apply the buffer first, so every result is as if the inserts had
+* happened one by one. Trees whose insert does its own descent
+* (StringAVLTree, InternedAVLTree) still insert at once. Calling it again
+* while already in bulk mode does nothing.
+*/
+template<class Key, class Value>
+void AVLTree<Key, Value>::beginBulk ()
+{
+    bulk_ = true;
+}
+
+template<class Key, class Value>
+bool AVLTree<Key, Value>::inBulk () const
+{
+    return bulk_;
+}
+
+/**
+* Ends a bulk load and applies the inserts it buffered. Does nothing
+* outside bulk mode.
+*/
+template<class Key, class Value>
+void AVLTree<Key, Value>::endBulk ()
+{
+    if (!bulk_){
+      return;
+    }
+    bulk_ = false;
+    applyBulk();
+}
+
+/**
+* Applies the k inserts buffered in bulk mode in O(k log k) plus the cost
+* of linking them. They are stably sorted by key, and of each run of
+* equal keys only the last is kept, as the inserts in turn would leave it.
+* An empty tree is then built like buildSorted in O(k). Otherwise keys
+* past the largest one are linked under it without a descent, and the
+* rest are inserted in key order, so consecutive descents share most of
+* their path and find it in cache. Hooks fire as for ordinary inserts.
+*/
+template<class Key, class Value>
+void AVLTree<Key, Value>::applyBulk ()
+{
+    if (bulkItems_.empty()){
+      return;
+    }
+    std::vector<std::pair<Key, Value> > items;
+    items.swap(bulkItems_);
+    std::stable_sort(items.begin(), items.end(),
+                     [](const std::pair<Key, Value>& a, const std::pair<Key, Value>& b) {
+                       return a.first < b.first;
+                     });
+    size_t kept = 0;
+    for (size_t i = 0; i < items.size(); i++){
+      if (kept > 0 && !(items[kept - 1].first < items[i].first)){
+        items[kept - 1].second = std::move(items[i].second);
+      }
+      else {
+        if (kept != i){
+          items[kept] = std::move(items[i]);
+        }
+        kept++;
+      }
+    }
+    items.erase(items.begin() + kept, items.end());
+
+    if (this->root_ == nullptr){
+      linkSorted(&items[0], items.size());
+      return;
+    }
+    for (size_t i = 0; i < items.size(); i++){
+      AVLNode<Key, Value>* largest = static_cast<AVLNode<Key, Value>*>(this->getLargestNode());
+      if (largest->getKey() < items[i].first){
+        linkNode(largest, createNode(items[i].first, items[i].second));
+      }
+      else {
+        insertNode(items[i].first, items[i].second);
+      }
+    }
+}
+
+/**
+* Rebuilds keep no state in the base tree.
+*/
+template<class Key, class Value>
+void AVLTree<Key, Value>::subtreeRebuilt(AVLNode<Key, Value>* root)
+{
+    (void)root;
+}
+
 template<class Key, class Value>
 void AVLTree<Key, Value>::insertFix (AVLNode<Key, Value>* parent, AVLNode<Key, Value>* node){
   /*
@@ -253,7 +760,8 @@ void AVLTree<Key, Value>::insertFix (AVLNode<Key, Value>* parent, AVLNode<Key, V
   if (gparent->getBalance() == 0){
     return;
   }
-  else if (gparent->getBalance() == 1 || gparent->getBalance() == -1){ //parent of gparent could be out of balance, work up ancestor chain
+  //parent of gparent could be out of balance, work up ancestor chain
+  else if (gparent->getBalance() == 1 || gparent->getBalance() == -1){
     insertFix(gparent, parent);
   }
 
@@ -324,16 +832,30 @@ void AVLTree<Key, Value>:: remove(const Key& key)
     - removeFix(p, diff) to patch tree
     */
 
+    //a key inserted earlier in a bulk load has to be in place to go
+    applyBulk();
     AVLNode<Key, Value>* node = static_cast<AVLNode<Key, Value>*>(this->internalFind(key));
     if (node == nullptr){
       //nothing to remove
       return;
     }
+    removeNode(node);
+}
+
+/**
+* Unlinks and deletes a node that is known to be in the tree, then
+* rebalances.
+*/
+template<class Key, class Value>
+void AVLTree<Key, Value>::removeNode(Node<Key, Value>* n)
+{
+    AVLNode<Key, Value>* node = static_cast<AVLNode<Key, Value>*>(n);
 
     if (node->getLeft() != nullptr && node->getRight() != nullptr){
       AVLNode<Key, Value>* pred = static_cast<AVLNode<Key, Value>*>(this->predecessor(node));
       nodeSwap(node, pred);
     }
+    this->nodeUnlinking(node);
 
     AVLNode<Key, Value>* parent = node->getParent();
 
@@ -364,6 +886,9 @@ void AVLTree<Key, Value>:: remove(const Key& key)
         //diff stays 1
       }
     }
+    if (finger_ == node){
+      finger_ = nullptr;
+    }
     delete node;
     removeFix(parent, diff);    
 }
@@ -511,6 +1036,7 @@ void AVLTree<Key, Value>:: rotateLeft(AVLNode<Key, Value>* node){
 
   rchild->setLeft(node);
   node->setParent(rchild);
+  nodeRotated(node);
 }
 
 template<typename Key, typename Value>
@@ -547,6 +1073,16 @@ void AVLTree<Key, Value>:: rotateRight(AVLNode<Key, Value>* node){
 
   lchild->setRight(node);
   node->setParent(lchild); 
+  nodeRotated(node);
+}
+
+/**
+* Rotations keep no state in the base tree.
+*/
+template<class Key, class Value>
+void AVLTree<Key, Value>::nodeRotated(AVLNode<Key, Value>* down)
+{
+    (void)down;
 }
 
 template<class Key, class Value>
@@ -0,0 +1,360 @@
+#ifndef AVLSET_H
+#define AVLSET_H
+
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include "compactavl.h"
+
+/**
+* A node for AVLSet: the key and two links, with the balance factor in the
+* two low bits of the left link as in CompactAVLNode. There is no value,
+* so no std::pair and none of the padding a one-byte dummy value costs.
+*/
+template <typename Key>
+class AVLSetNode
+{
+public:
+    explicit AVLSetNode(const Key& key);
+
+    const Key& getKey() const;
+
+    AVLSetNode<Key>* getLeft() const;
+    AVLSetNode<Key>* getRight() const;
+    AVLSetNode<Key>* getChild(int dir) const;
+    void setLeft(AVLSetNode<Key>* left);
+    void setRight(AVLSetNode<Key>* right);
+    void setChild(int dir, AVLSetNode<Key>* child);
+
+    // height(right) - height(left), only -1, 0 and 1 can be stored
+    int8_t getBalance() const;
+    void setBalance(int8_t balance);
+
+protected:
+    // balance + 1 (0, 1 or 2) is stored in these bits of left_
+    static const uintptr_t BALANCE_MASK = 3;
+
+    const Key key_;
+    uintptr_t left_;
+    AVLSetNode<Key>* right_;
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the AVLSetNode class.
+  -------------------------------------------------
+*/
+
+template<class Key>
+AVLSetNode<Key>::AVLSetNode(const Key& key) :
+    key_(key), left_(1), right_(nullptr)
+{
+  //left_ == 1 is a null left child with balance 0
+}
+
+template<class Key>
+const Key& AVLSetNode<Key>::getKey() const
+{
+    return key_;
+}
+
+/**
+* Masks the balance bits off the left link.
+*/
+template<class Key>
+AVLSetNode<Key>* AVLSetNode<Key>::getLeft() const
+{
+    return reinterpret_cast<AVLSetNode<Key>*>(left_ & ~BALANCE_MASK);
+}
+
+template<class Key>
+AVLSetNode<Key>* AVLSetNode<Key>::getRight() const
+{
+    return right_;
+}
+
+/**
+* dir is 0 for the left child and 1 for the right child.
+*/
+template<class Key>
+AVLSetNode<Key>* AVLSetNode<Key>::getChild(int dir) const
+{
+    return dir == 0 ? getLeft() : getRight();
+}
+
+/**
+* Sets the left child while keeping the balance bits.
+*/
+template<class Key>
+void AVLSetNode<Key>::setLeft(AVLSetNode<Key>* left)
+{
+    left_ = reinterpret_cast<uintptr_t>(left) | (left_ & BALANCE_MASK);
+}
+
+template<class Key>
+void AVLSetNode<Key>::setRight(AVLSetNode<Key>* right)
+{
+    right_ = right;
+}
+
+template<class Key>
+void AVLSetNode<Key>::setChild(int dir, AVLSetNode<Key>* child)
+{
+    if (dir == 0){
+      setLeft(child);
+    }
+    else {
+      setRight(child);
+    }
+}
+
+template<class Key>
+int8_t AVLSetNode<Key>::getBalance() const
+{
+    return (int8_t)((int)(left_ & BALANCE_MASK) - 1);
+}
+
+template<class Key>
+void AVLSetNode<Key>::setBalance(int8_t balance)
+{
+    left_ = (left_ & ~BALANCE_MASK) | (uintptr_t)(balance + 1);
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the AVLSetNode class.
+  -----------------------------------------------
+*/
+
+/**
+* An ordered set of keys, for indices that would otherwise be an
+* AVLTree<Key, char> kept only for its ordering. It runs the same
+* parent-free AVL insert/remove as CompactAVLTree (CompactAVLAlgorithms),
+* on nodes that hold just the key and two links. For int keys a node is 24
+* bytes against 48 for an AVLNode<int, char>.
+*
+* Iterators visit the keys in increasing order and are read-only, since
+* changing a key in place would break the ordering.
+*/
+template <class Key>
+class AVLSet
+{
+public:
+    AVLSet();
+    ~AVLSet();
+
+    bool insert(const Key& key);
+    bool erase(const Key& key);
+    bool contains(const Key& key) const;
+    void clear();
+    bool empty() const;
+    size_t size() const;
+    bool isBalanced() const;
+
+    /**
+    * An iterator that keeps the path from the root to the current node.
+    */
+    class iterator
+    {
+    public:
+        iterator();
+
+        const Key& operator*() const;
+        const Key* operator->() const;
+
+        bool operator==(const iterator& rhs) const;
+        bool operator!=(const iterator& rhs) const;
+
+        iterator& operator++();
+
+    protected:
+        friend class AVLSet<Key>;
+
+        CompactAVLPath<AVLSetNode<Key> > path_;
+    };
+
+    iterator begin() const;
+    iterator end() const;
+    iterator find(const Key& key) const;
+
+protected:
+    typedef CompactAVLAlgorithms<AVLSetNode<Key> > Algorithms;
+
+private:
+    // nodes are owned, and copying would share them
+    AVLSet(const AVLSet&);
+    AVLSet& operator=(const AVLSet&);
+
+protected:
+    AVLSetNode<Key>* root_;
+    size_t size_;
+};
+
+/*
+--------------------------------------------------------------
+Begin implementations for the AVLSet::iterator class.
+---------------------------------------------------------------
+*/
+
+template<class Key>
+AVLSet<Key>::iterator::iterator()
+{
+
+}
+
+template<class Key>
+const Key& AVLSet<Key>::iterator::operator*() const
+{
+    return path_.current()->getKey();
+}
+
+template<class Key>
+const Key* AVLSet<Key>::iterator::operator->() const
+{
+    return &(path_.current()->getKey());
+}
+
+template<class Key>
+bool AVLSet<Key>::iterator::operator==(const iterator& rhs) const
+{
+    return path_.current() == rhs.path_.current();
+}
+
+template<class Key>
+bool AVLSet<Key>::iterator::operator!=(const iterator& rhs) const
+{
+    return path_.current() != rhs.path_.current();
+}
+
+template<class Key>
+typename AVLSet<Key>::iterator& AVLSet<Key>::iterator::operator++()
+{
+    path_.next();
+    return *this;
+}
+
+/*
+-------------------------------------------------------------
+End implementations for the AVLSet::iterator class.
+-------------------------------------------------------------
+*/
+
+/*
+-----------------------------------------------------
+Begin implementations for the AVLSet class.
+-----------------------------------------------------
+*/
+
+template<class Key>
+AVLSet<Key>::AVLSet() :
+  root_(nullptr), size_(0)
+{
+
+}
+
+template<class Key>
+AVLSet<Key>::~AVLSet()
+{
+    clear();
+}
+
+/**
+* Adds key and returns true, or returns false if it was already there.
+*/
+template<class Key>
+bool AVLSet<Key>::insert(const Key& key)
+{
+    bool inserted;
+    Algorithms::insert(root_, key, [&key]() {
+      return new AVLSetNode<Key>(key);
+    }, inserted);
+    if (inserted){
+      size_++;
+    }
+    return inserted;
+}
+
+/**
+* Removes key and returns true, or returns false if it was not there.
+*/
+template<class Key>
+bool AVLSet<Key>::erase(const Key& key)
+{
+    if (!Algorithms::remove(root_, key)){
+      return false;
+    }
+    size_--;
+    return true;
+}
+
+template<class Key>
+bool AVLSet<Key>::contains(const Key& key) const
+{
+    return Algorithms::find(root_, key) != nullptr;
+}
+
+template<class Key>
+void AVLSet<Key>::clear()
+{
+    Algorithms::destroy(root_);
+    root_ = nullptr;
+    size_ = 0;
+}
+
+template<class Key>
+bool AVLSet<Key>::empty() const
+{
+    return root_ == nullptr;
+}
+
+template<class Key>
+size_t AVLSet<Key>::size() const
+{
+    return size_;
+}
+
+/**
+ * Return true iff the tree is balanced and every stored balance factor
+ * matches the actual subtree heights.
+ */
+template<class Key>
+bool AVLSet<Key>::isBalanced() const
+{
+    return Algorithms::checkBalance(root_) != -1;
+}
+
+template<class Key>
+typename AVLSet<Key>::iterator AVLSet<Key>::begin() const
+{
+    iterator it;
+    it.path_.first(root_);
+    return it;
+}
+
+template<class Key>
+typename AVLSet<Key>::iterator AVLSet<Key>::end() const
+{
+    return iterator();
+}
+
+/**
+* Returns an iterator to key, or end().
+*/
+template<class Key>
+typename AVLSet<Key>::iterator AVLSet<Key>::find(const Key& key) const
+{
+    iterator it;
+    it.path_.seek(root_, key);
+    return it;
+}
+
+/*
+---------------------------------------------------
+End implementations for the AVLSet class.
+---------------------------------------------------
+*/
+
+#endif
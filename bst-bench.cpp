@@ -0,0 +1,1098 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <climits>
+#include <thread>
+#include <mutex>
+#include <fstream>
+#include "bst.h"
+#include "avlbst.h"
+#include "rbbst.h"
+#include "compactavl.h"
+#include "threadedavl.h"
+#include "augmentedavl.h"
+#include "intervaltree.h"
+#include "merkleavl.h"
+#include "avlset.h"
+#include "smallmap.h"
+#include "hashedavl.h"
+#include "stringavl.h"
+#include "internedavl.h"
+#include "radixtree.h"
+#include "shardedavl.h"
+#include "lsmtree.h"
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+using namespace std;
+
+// Throughput harness for the search trees. Every benchmark prints one row of
+// "name  operations  Mops/s" so runs can be diffed against each other.
+// Usage: ./bst-bench [n]   (default n = 1000000)
+
+typedef chrono::steady_clock Clock;
+
+double elapsedSeconds(Clock::time_point start)
+{
+  return chrono::duration<double>(Clock::now() - start).count();
+}
+
+void report(const string& name, size_t ops, double seconds)
+{
+  cout << left << setw(46) << name << right << setw(10) << ops
+       << setw(10) << fixed << setprecision(2) << (ops / seconds / 1e6) << " Mops/s" << endl;
+}
+
+// Results the benchmarks compute are stored here, so the compiler cannot
+// drop the loops that compute them.
+volatile long long benchSink;
+
+template<typename T>
+void doNotOptimize(const T& value)
+{
+  benchSink = (long long)value;
+}
+
+vector<int> shuffledKeys(size_t n, unsigned seed)
+{
+  vector<int> keys(n);
+  for (size_t i = 0; i < n; i++){
+    keys[i] = (int)i;
+  }
+  shuffle(keys.begin(), keys.end(), mt19937(seed));
+  return keys;
+}
+
+// Inserts every key, removes them again in a different order, then runs a
+// churn phase where each step removes one live key and inserts a fresh one.
+template<typename Tree>
+void benchChurn(const string& name, const vector<int>& keys)
+{
+  size_t n = keys.size();
+  vector<int> removeOrder(keys);
+  shuffle(removeOrder.begin(), removeOrder.end(), mt19937(7));
+
+  Tree tree;
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    tree.insert(make_pair(keys[i], (int)i));
+  }
+  report(name + " insert", n, elapsedSeconds(start));
+
+  start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    tree.remove(removeOrder[i]);
+  }
+  report(name + " remove", n, elapsedSeconds(start));
+
+  for (size_t i = 0; i < n / 2; i++){
+    tree.insert(make_pair(keys[i], (int)i));
+  }
+  start = Clock::now();
+  for (size_t i = 0; i < n / 2; i++){
+    tree.remove(keys[i]);
+    tree.insert(make_pair(keys[i + n / 2], (int)i));
+  }
+  report(name + " churn (remove+insert)", n, elapsedSeconds(start));
+}
+
+// Monotonic keys, and the same keys with each one displaced by up to
+// +-window positions (window = 0 gives the sorted stream).
+vector<int> nearlySortedKeys(size_t n, size_t window, unsigned seed)
+{
+  vector<int> keys(n);
+  for (size_t i = 0; i < n; i++){
+    keys[i] = (int)i;
+  }
+  if (window > 0){
+    mt19937 gen(seed);
+    for (size_t i = 0; i + window < n; i += window){
+      shuffle(keys.begin() + i, keys.begin() + i + window, gen);
+    }
+  }
+  return keys;
+}
+
+void benchHinted(const string& name, const vector<int>& keys)
+{
+  size_t n = keys.size();
+  {
+    AVLTree<int, int> tree;
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < n; i++){
+      tree.insert(make_pair(keys[i], (int)i));
+    }
+    report(name + " insert", n, elapsedSeconds(start));
+  }
+  {
+    AVLTree<int, int> tree;
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < n; i++){
+      tree.insert(tree.end(), make_pair(keys[i], (int)i));
+    }
+    report(name + " insert(end())", n, elapsedSeconds(start));
+  }
+  {
+    AVLTree<int, int> tree;
+    AVLTree<int, int>::iterator hint = tree.end();
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < n; i++){
+      hint = tree.emplace_hint(hint, keys[i], (int)i);
+      ++hint;
+    }
+    report(name + " emplace_hint(prev+1)", n, elapsedSeconds(start));
+  }
+}
+
+// Uses the tree as a priority queue: drain it through remove(begin()->first)
+// (a full descent per pop) versus popMin (unlinks the cached leftmost node).
+void benchPopMin(const vector<int>& keys)
+{
+  size_t n = keys.size();
+  {
+    AVLTree<int, int> tree;
+    for (size_t i = 0; i < n; i++){
+      tree.insert(make_pair(keys[i], (int)i));
+    }
+    Clock::time_point start = Clock::now();
+    while (!tree.empty()){
+      tree.remove(tree.begin()->first);
+    }
+    report("AVLTree remove(begin()->first)", n, elapsedSeconds(start));
+  }
+  {
+    AVLTree<int, int> tree;
+    for (size_t i = 0; i < n; i++){
+      tree.insert(make_pair(keys[i], (int)i));
+    }
+    Clock::time_point start = Clock::now();
+    while (!tree.empty()){
+      tree.popMin();
+    }
+    report("AVLTree popMin()", n, elapsedSeconds(start));
+  }
+}
+
+// Insert, lookup and full in-order scan, for comparing node layouts.
+template<typename Tree>
+void benchLayout(const string& name, const vector<int>& keys)
+{
+  size_t n = keys.size();
+  Tree tree;
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    tree.insert(make_pair(keys[i], (int)i));
+  }
+  report(name + " insert", n, elapsedSeconds(start));
+
+  long long sum = 0;
+  start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    sum += tree.find(keys[i])->second;
+  }
+  report(name + " find", n, elapsedSeconds(start));
+
+  start = Clock::now();
+  for (typename Tree::iterator it = tree.begin(); it != tree.end(); ++it){
+    sum += it->second;
+  }
+  report(name + " scan", n, elapsedSeconds(start));
+
+  start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    tree.remove(keys[i]);
+  }
+  report(name + " remove", n, elapsedSeconds(start));
+  doNotOptimize(sum);
+}
+
+// Builds a perfect tree of the given height out of nodes[next...]. With
+// shortLeft set, the leftmost bottom pair is dropped so its parent becomes
+// a leaf one level too high, which equalPaths can reject after one descent.
+Node<int, int>* buildPerfect(vector<Node<int, int>*>& nodes, size_t& next, int height, bool shortLeft)
+{
+  if (height == 0){
+    return nullptr;
+  }
+  Node<int, int>* node = nodes[next++];
+  if (shortLeft && height == 2){
+    node->setLeft(nullptr);
+    node->setRight(nullptr);
+    return node;
+  }
+  Node<int, int>* left = buildPerfect(nodes, next, height - 1, shortLeft);
+  Node<int, int>* right = buildPerfect(nodes, next, height - 1, false);
+  node->setLeft(left);
+  node->setRight(right);
+  if (left != nullptr) left->setParent(node);
+  if (right != nullptr) right->setParent(node);
+  return node;
+}
+
+void benchEqualPaths(size_t n)
+{
+  vector<Node<int, int>*> nodes(n);
+  for (size_t i = 0; i < n; i++){
+    nodes[i] = new Node<int, int>((int)i, 0, nullptr);
+  }
+  int reps = 10;
+
+  // skewed: one long chain, deep enough to overflow a recursive walk
+  for (size_t i = 0; i + 1 < n; i++){
+    nodes[i]->setRight(nodes[i + 1]);
+    nodes[i + 1]->setParent(nodes[i]);
+  }
+  bool result = true;
+  Clock::time_point start = Clock::now();
+  for (int r = 0; r < reps; r++){
+    result = equalPaths(nodes[0]) && result;
+  }
+  report("equalPaths skewed chain (nodes)", n * reps, elapsedSeconds(start));
+
+  int height = 0;
+  while (((size_t)2 << height) - 1 <= n){
+    height++;
+  }
+  size_t perfectSize = ((size_t)1 << height) - 1;
+  for (size_t i = 0; i < n; i++){
+    nodes[i]->setLeft(nullptr);
+    nodes[i]->setRight(nullptr);
+  }
+  size_t next = 0;
+  Node<int, int>* root = buildPerfect(nodes, next, height, false);
+  start = Clock::now();
+  for (int r = 0; r < reps; r++){
+    result = equalPaths(root) && result;
+  }
+  report("equalPaths perfect tree (nodes)", perfectSize * reps, elapsedSeconds(start));
+
+  next = 0;
+  root = buildPerfect(nodes, next, height, true);
+  start = Clock::now();
+  for (int r = 0; r < reps; r++){
+    result = !equalPaths(root) && result;
+  }
+  report("equalPaths perfect, bad leftmost (nodes)", perfectSize * reps, elapsedSeconds(start));
+
+  if (!result){
+    cout << "equalPaths returned a wrong answer" << endl;
+  }
+  for (size_t i = 0; i < n; i++){
+    delete nodes[i];
+  }
+}
+
+// One full AVL validation pass (order, height balance, balance_ fields)
+// on pools of increasing size, against the sequential isBalanced().
+void benchValidate(const vector<int>& keys)
+{
+  size_t n = keys.size();
+  AVLTree<int, int> tree;
+  for (size_t i = 0; i < n; i++){
+    tree.insert(make_pair(keys[i], (int)i));
+  }
+
+  Clock::time_point start = Clock::now();
+  bool ok = tree.isBalanced();
+  report("isBalanced (nodes)", n, elapsedSeconds(start));
+
+  unsigned maxThreads = std::max(4u, thread::hardware_concurrency());
+  for (unsigned threads = 1; threads <= maxThreads; threads *= 2){
+    WorkStealingPool pool(threads);
+    start = Clock::now();
+    ok = tree.validate(CHECK_ORDER | CHECK_HEIGHT_BALANCE | CHECK_BALANCE_FIELD, pool).ok && ok;
+    report("validate, " + to_string(threads) + " threads (nodes)", n, elapsedSeconds(start));
+  }
+  if (!ok){
+    cout << "validate found a problem in a valid tree" << endl;
+  }
+}
+
+// analyze() against the separate passes it replaces (isBalanced for the
+// shape, an iterator scan for the count), and the sampled estimate.
+void benchAnalyze(const vector<int>& keys)
+{
+  size_t n = keys.size();
+  AVLTree<int, int> tree;
+  for (size_t i = 0; i < n; i++){
+    tree.insert(make_pair(keys[i], (int)i));
+  }
+
+  Clock::time_point start = Clock::now();
+  size_t count = 0;
+  bool balanced = tree.isBalanced();
+  for (AVLTree<int, int>::iterator it = tree.begin(); it != tree.end(); ++it){
+    count++;
+  }
+  report("isBalanced + iterator scan (nodes)", n, elapsedSeconds(start));
+
+  start = Clock::now();
+  TreeStats full = tree.analyze();
+  report("analyze() (nodes)", n, elapsedSeconds(start));
+
+  size_t samples = 1000;
+  start = Clock::now();
+  TreeStats sampled = tree.analyze(samples);
+  report("analyze(1000 samples) (descents)", samples, elapsedSeconds(start));
+
+  cout << "  full:    ";
+  full.writeJson(cout);
+  cout << endl << "  sampled: ";
+  sampled.writeJson(cout);
+  cout << endl;
+  if (full.nodes != count || !balanced){
+    cout << "analyze disagrees with the separate passes" << endl;
+  }
+}
+
+// Full DOT and JSON dumps of an AVL tree to /dev/null, so the numbers are
+// the exporter's own cost.
+void benchExport(const vector<int>& keys)
+{
+  size_t n = keys.size();
+  AVLTree<int, int> tree;
+  for (size_t i = 0; i < n; i++){
+    tree.insert(make_pair(keys[i], (int)i));
+  }
+
+  ofstream out("/dev/null");
+  Clock::time_point start = Clock::now();
+  tree.exportTree(out, EXPORT_DOT);
+  report("exportTree DOT (nodes)", n, elapsedSeconds(start));
+
+  start = Clock::now();
+  tree.exportTree(out, EXPORT_JSON);
+  report("exportTree JSON (nodes)", n, elapsedSeconds(start));
+}
+
+// Sums every value with an iterator loop, then with parallel_reduce and a
+// parallel_for_each that updates the values in place, on growing pools.
+void benchParallel(const vector<int>& keys)
+{
+  size_t n = keys.size();
+  AVLTree<int, long long> tree;
+  for (size_t i = 0; i < n; i++){
+    tree.insert(make_pair(keys[i], (long long)keys[i]));
+  }
+
+  Clock::time_point start = Clock::now();
+  long long expected = 0;
+  for (AVLTree<int, long long>::iterator it = tree.begin(); it != tree.end(); ++it){
+    expected += it->second;
+  }
+  report("iterator sum (nodes)", n, elapsedSeconds(start));
+
+  bool ok = true;
+  unsigned maxThreads = std::max(4u, thread::hardware_concurrency());
+  for (unsigned threads = 1; threads <= maxThreads; threads *= 2){
+    WorkStealingPool pool(threads);
+    start = Clock::now();
+    long long sum = parallel_reduce(tree, INT_MIN, INT_MAX, 0LL,
+                                    [](long long a, long long b) { return a + b; }, pool);
+    report("parallel_reduce, " + to_string(threads) + " threads (nodes)", n, elapsedSeconds(start));
+    ok = ok && sum == expected;
+
+    start = Clock::now();
+    parallel_for_each(tree, [](pair<const int, long long>& item) { item.second++; }, pool);
+    report("parallel_for_each, " + to_string(threads) + " threads (nodes)", n, elapsedSeconds(start));
+    expected += (long long)n;
+  }
+  if (!ok){
+    cout << "parallel_reduce returned a wrong sum" << endl;
+  }
+}
+
+// Random lookups on a tree much larger than the cache, one find() at a
+// time versus findBatch() over batches of the given size.
+void benchFindBatch(const vector<int>& keys, size_t batch)
+{
+  size_t n = keys.size();
+  AVLTree<int, int> tree;
+  for (size_t i = 0; i < n; i++){
+    tree.insert(make_pair(keys[i], (int)i));
+  }
+  vector<int> probes = shuffledKeys(n, 99);
+
+  long long sum = 0;
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    sum += tree.find(probes[i])->second;
+  }
+  report("find, one at a time", n, elapsedSeconds(start));
+
+  long long batchSum = 0;
+  vector<int> chunk;
+  vector<AVLTree<int, int>::iterator> found;
+  start = Clock::now();
+  for (size_t i = 0; i < n; i += batch){
+    chunk.assign(probes.begin() + i, probes.begin() + std::min(n, i + batch));
+    tree.findBatch(chunk, found);
+    for (size_t j = 0; j < found.size(); j++){
+      batchSum += found[j]->second;
+    }
+  }
+  report("findBatch, batches of " + to_string(batch), n, elapsedSeconds(start));
+  if (sum != batchSum){
+    cout << "findBatch found different items than find" << endl;
+  }
+}
+
+// Sums over random key ranges of about a thousand keys: by walking the
+// range with iterators on an AVLTree versus aggregate() on an
+// AugmentedAVLTree, plus what keeping the aggregates costs on insert.
+void benchAggregate(const vector<int>& keys)
+{
+  size_t n = keys.size();
+  AVLTree<int, long long> plain;
+  AugmentedAVLTree<int, long long> augmented;
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    augmented.insert(make_pair(keys[i], (long long)keys[i]));
+  }
+  report("AugmentedAVLTree insert", n, elapsedSeconds(start));
+  for (size_t i = 0; i < n; i++){
+    plain.insert(make_pair(keys[i], (long long)keys[i]));
+  }
+
+  size_t queries = 20000;
+  mt19937 gen(5);
+  vector<int> los(queries);
+  for (size_t q = 0; q < queries; q++){
+    los[q] = (int)(gen() % n);
+  }
+
+  long long iterated = 0;
+  start = Clock::now();
+  for (size_t q = 0; q < queries; q++){
+    AVLTree<int, long long>::iterator it = plain.find(los[q]);
+    for (int k = 0; k < 1000 && it != plain.end(); k++, ++it){
+      iterated += it->second;
+    }
+  }
+  report("range sum, iteration (keys covered)", queries * 1000, elapsedSeconds(start));
+
+  long long aggregated = 0;
+  start = Clock::now();
+  for (size_t q = 0; q < queries; q++){
+    aggregated += augmented.aggregate(los[q], los[q] + 1000);
+  }
+  report("range sum, aggregate() (keys covered)", queries * 1000, elapsedSeconds(start));
+  if (iterated != aggregated){
+    cout << "aggregate() disagrees with iteration" << endl;
+  }
+}
+
+// Short random intervals: overlap queries through IntervalTree versus a
+// scan of an AVLTree keyed by start, which has to look at every interval
+// starting before the query ends.
+void benchIntervals(size_t n)
+{
+  mt19937 gen(3);
+  IntervalTree<int, int> tree;
+  AVLTree<int, int> byStart;
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    int s = (int)(gen() % (n * 10));
+    tree.insert(s, s + (int)(gen() % 100), (int)i);
+  }
+  report("IntervalTree insert", n, elapsedSeconds(start));
+  for (IntervalTree<int, int>::iterator it = tree.begin(); it != tree.end(); ++it){
+    byStart.insert(make_pair(it->first.start, it->first.end)); //keeps the longest per start
+  }
+
+  size_t queries = 100000;
+  size_t found = 0;
+  start = Clock::now();
+  for (size_t q = 0; q < queries; q++){
+    int lo = (int)(gen() % (n * 10));
+    found += tree.countOverlapping(lo, lo + 50);
+  }
+  report("IntervalTree countOverlapping", queries, elapsedSeconds(start));
+
+  size_t scans = 20;
+  size_t visited = 0;
+  start = Clock::now();
+  for (size_t q = 0; q < scans; q++){
+    int lo = (int)(gen() % (n * 10));
+    for (AVLTree<int, int>::iterator it = byStart.begin(); it != byStart.end() && it->first <= lo + 50; ++it){
+      found += it->second >= lo;
+      visited++;
+    }
+  }
+  double seconds = elapsedSeconds(start);
+  report("AVLTree scan by start (intervals visited)", visited, seconds);
+  cout << "  = " << fixed << setprecision(1) << scans / seconds << " queries/s" << endl;
+  doNotOptimize(found);
+}
+
+void benchMerkleDiff(const vector<int>& keys, size_t differences)
+{
+  MerkleAVLTree<int, int> a;
+  MerkleAVLTree<int, int> b;
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < keys.size(); i++){
+    a.insert(make_pair(keys[i], keys[i]));
+  }
+  report("MerkleAVLTree insert", keys.size(), elapsedSeconds(start));
+  for (size_t i = keys.size(); i-- > 0; ){
+    b.insert(make_pair(keys[i], keys[i]));
+  }
+  for (size_t i = 0; i < differences && i < keys.size(); i++){
+    b.update(keys[i], -1);
+  }
+
+  size_t rounds = 100;
+  size_t found = 0;
+  start = Clock::now();
+  for (size_t r = 0; r < rounds; r++){
+    found += a.diff(b).size();
+  }
+  double seconds = elapsedSeconds(start);
+  cout << "MerkleAVLTree diff, " << differences << " differences: "
+       << fixed << setprecision(1) << rounds / seconds << " diffs/s" << endl;
+
+  //the alternative: walk both trees side by side
+  size_t scans = 3;
+  start = Clock::now();
+  for (size_t r = 0; r < scans; r++){
+    MerkleAVLTree<int, int>::iterator x = a.begin();
+    MerkleAVLTree<int, int>::iterator y = b.begin();
+    for ( ; x != a.end() && y != b.end(); ++x, ++y){
+      found += x->first != y->first || x->second != y->second;
+    }
+  }
+  seconds = elapsedSeconds(start);
+  cout << "  vs full side-by-side scan: " << fixed << setprecision(1) << scans / seconds << " diffs/s" << endl;
+  doNotOptimize(found);
+}
+
+// Bytes currently allocated from the heap, or 0 where that is not known.
+size_t heapBytes()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  return mallinfo2().uordblks;
+#else
+  return 0;
+#endif
+}
+
+// Inserts the keys into an AVLTree<Key, char>, a CompactAVLTree<Key, char>
+// and an AVLSet<Key> and prints the heap bytes each uses per key (including
+// allocator overhead), then times set inserts, lookups and erases.
+template<typename Key>
+void benchSetMemory(const string& name, const vector<Key>& keys)
+{
+  size_t n = keys.size();
+  size_t before = heapBytes();
+  AVLTree<Key, char>* tree = new AVLTree<Key, char>();
+  for (size_t i = 0; i < n; i++){
+    tree->insert(make_pair(keys[i], 'x'));
+  }
+  double treeBytes = (double)(heapBytes() - before) / n;
+  delete tree;
+
+  before = heapBytes();
+  CompactAVLTree<Key, char>* compact = new CompactAVLTree<Key, char>();
+  for (size_t i = 0; i < n; i++){
+    compact->insert(make_pair(keys[i], 'x'));
+  }
+  double compactBytes = (double)(heapBytes() - before) / n;
+  delete compact;
+
+  before = heapBytes();
+  AVLSet<Key> set;
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    set.insert(keys[i]);
+  }
+  double seconds = elapsedSeconds(start);
+  double setBytes = (double)(heapBytes() - before) / n;
+
+  cout << "bytes per " << name << " key: AVLTree<" << name << ", char> " << fixed << setprecision(1) << treeBytes
+       << ", CompactAVLTree<" << name << ", char> " << compactBytes
+       << ", AVLSet<" << name << "> " << setBytes << endl;
+  report("AVLSet<" + name + "> insert", n, seconds);
+
+  size_t found = 0;
+  start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    found += set.contains(keys[i]);
+  }
+  report("AVLSet<" + name + "> contains", n, elapsedSeconds(start));
+
+  start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    set.erase(keys[i]);
+  }
+  report("AVLSet<" + name + "> erase", n, elapsedSeconds(start));
+  if (found != n){
+    cout << "AVLSet lost keys" << endl;
+  }
+}
+
+// Many tiny maps, as in a per-object attribute index: fills `maps` maps
+// with `entries` keys each, then looks every key up, in AVLTrees and in
+// SmallAVLMaps, and prints the heap bytes per entry of each.
+template<typename Map>
+void benchTinyMaps(const string& name, size_t maps, size_t entries)
+{
+  mt19937 gen(9);
+  size_t before = heapBytes();
+  Clock::time_point start = Clock::now();
+  vector<Map*> all(maps);
+  for (size_t m = 0; m < maps; m++){
+    all[m] = new Map();
+    for (size_t e = 0; e < entries; e++){
+      all[m]->insert(make_pair((int)(gen() % 1000), (int)e));
+    }
+  }
+  report(name + " insert", maps * entries, elapsedSeconds(start));
+  double bytes = (double)(heapBytes() - before) / (maps * entries);
+
+  long long sum = 0;
+  start = Clock::now();
+  for (size_t m = 0; m < maps; m++){
+    for (int k = 0; k < 1000; k += 1000 / (int)entries){
+      typename Map::iterator it = all[m]->find(k);
+      if (it != all[m]->end()){
+        sum += it->second;
+      }
+    }
+  }
+  report(name + " find", maps * entries, elapsedSeconds(start));
+  cout << "  " << fixed << setprecision(1) << bytes << " heap bytes per entry, including the map object" << endl;
+  for (size_t m = 0; m < maps; m++){
+    delete all[m];
+  }
+  doNotOptimize(sum);
+}
+
+// Point lookups (find and operator[]) against ordered scans, the workload
+// HashedAVLTree is for, with the plain AVLTree as the baseline.
+template<typename Tree>
+void benchPointLookups(const string& name, const vector<int>& keys)
+{
+  size_t n = keys.size();
+  Tree tree;
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    tree.insert(make_pair(keys[i], (int)i));
+  }
+  report(name + " insert", n, elapsedSeconds(start));
+
+  long long sum = 0;
+  start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    sum += tree.find(keys[n - 1 - i])->second;
+  }
+  report(name + " find", n, elapsedSeconds(start));
+
+  start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    sum += tree[keys[i]];
+  }
+  report(name + " operator[]", n, elapsedSeconds(start));
+
+  start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    tree.remove(keys[i]);
+  }
+  report(name + " remove", n, elapsedSeconds(start));
+  doNotOptimize(sum);
+}
+
+// Random lowercase keys of the given length, unique.
+vector<string> stringKeys(size_t n, size_t length, unsigned seed)
+{
+  mt19937 gen(seed);
+  vector<string> keys(n);
+  for (size_t i = 0; i < n; i++){
+    string key(length, 'a');
+    for (size_t j = 0; j < length; j++){
+      key[j] = (char)('a' + gen() % 26);
+    }
+    //append the index so keys stay unique
+    keys[i] = key + to_string(i);
+  }
+  return keys;
+}
+
+template<typename Tree>
+void benchStringKeys(const string& name, const vector<string>& keys)
+{
+  size_t n = keys.size();
+  Tree tree;
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    tree.insert(make_pair(keys[i], (int)i));
+  }
+  report(name + " insert", n, elapsedSeconds(start));
+
+  long long sum = 0;
+  start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    sum += tree.find(keys[n - 1 - i])->second;
+  }
+  report(name + " find", n, elapsedSeconds(start));
+  doNotOptimize(sum);
+}
+
+// Heap bytes per key, lookups and an in-order scan for string keys held
+// as std::strings and as StringRefs into an InternedAVLTree's arena.
+template<typename Tree>
+void benchInternedKeys(const string& name, const vector<string>& keys)
+{
+  size_t n = keys.size();
+  size_t before = heapBytes();
+  Tree* tree = new Tree();
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    tree->insert(make_pair(keys[i], (int)i));
+  }
+  report(name + " insert", n, elapsedSeconds(start));
+  double bytes = (double)(heapBytes() - before) / n;
+
+  long long sum = 0;
+  start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    sum += tree->find(keys[n - 1 - i])->second;
+  }
+  report(name + " find", n, elapsedSeconds(start));
+
+  size_t length = 0;
+  start = Clock::now();
+  for (typename Tree::iterator it = tree->begin(); it != tree->end(); ++it){
+    length += it->first < keys[0];
+  }
+  report(name + " scan", n, elapsedSeconds(start));
+  cout << "  " << fixed << setprecision(1) << bytes << " heap bytes per key" << endl;
+  delete tree;
+  doNotOptimize(sum + length);
+}
+
+// Integer keys in an AVLTree and in the RadixTree that OrderedMapFor picks
+// for them: inserts, lookups, an in-order scan and removes, plus heap
+// bytes per key.
+template<typename Tree>
+void benchIntegerKeys(const string& name, const vector<int>& keys)
+{
+  size_t n = keys.size();
+  size_t before = heapBytes();
+  Tree* tree = new Tree();
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    tree->insert(make_pair(keys[i], (int)i));
+  }
+  report(name + " insert", n, elapsedSeconds(start));
+  double bytes = (double)(heapBytes() - before) / n;
+
+  long long sum = 0;
+  start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    sum += tree->find(keys[n - 1 - i])->second;
+  }
+  report(name + " find", n, elapsedSeconds(start));
+
+  start = Clock::now();
+  for (typename Tree::iterator it = tree->begin(); it != tree->end(); ++it){
+    sum += it->first;
+  }
+  report(name + " scan", n, elapsedSeconds(start));
+
+  start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    tree->remove(keys[i]);
+  }
+  report(name + " remove", n, elapsedSeconds(start));
+  cout << "  " << fixed << setprecision(1) << bytes << " heap bytes per key" << endl;
+  delete tree;
+  doNotOptimize(sum);
+}
+
+// Inserts then removes every key from `threads` threads at once, each
+// thread taking every threads-th key, into an AVLTree behind one mutex and
+// into a ShardedAVLTree with 16 range shards.
+void benchShardedWrites(const vector<int>& keys)
+{
+  size_t n = keys.size();
+  vector<int> bounds;
+  for (int b = 1; b < 16; b++){
+    bounds.push_back((int)(n * b / 16));
+  }
+  unsigned maxThreads = std::max(4u, thread::hardware_concurrency());
+  for (unsigned threads = 1; threads <= maxThreads; threads *= 2){
+    AVLTree<int, int> tree;
+    mutex treeLock;
+    Clock::time_point start = Clock::now();
+    vector<thread> workers;
+    for (unsigned t = 0; t < threads; t++){
+      workers.push_back(thread([&, t]() {
+        for (size_t i = t; i < n; i += threads){
+          lock_guard<mutex> guard(treeLock);
+          tree.insert(make_pair(keys[i], (int)i));
+        }
+        for (size_t i = t; i < n; i += threads){
+          lock_guard<mutex> guard(treeLock);
+          tree.remove(keys[i]);
+        }
+      }));
+    }
+    for (size_t t = 0; t < workers.size(); t++){
+      workers[t].join();
+    }
+    report("AVLTree + mutex writes, " + to_string(threads) + " threads", 2 * n, elapsedSeconds(start));
+
+    ShardedAVLTree<int, int> sharded(bounds);
+    start = Clock::now();
+    workers.clear();
+    for (unsigned t = 0; t < threads; t++){
+      workers.push_back(thread([&, t]() {
+        for (size_t i = t; i < n; i += threads){
+          sharded.insert(make_pair(keys[i], (int)i));
+        }
+        for (size_t i = t; i < n; i += threads){
+          sharded.remove(keys[i]);
+        }
+      }));
+    }
+    for (size_t t = 0; t < workers.size(); t++){
+      workers[t].join();
+    }
+    report("ShardedAVLTree(16) writes, " + to_string(threads) + " threads", 2 * n, elapsedSeconds(start));
+  }
+
+  //every key in the first shard's range: one lock until rebalance spreads it
+  ShardedAVLTree<int, int> skewed(bounds);
+  int moves = 0;
+  for (int round = 0; round < 32; round++){
+    for (size_t i = round; i < n; i += 32){
+      skewed.insert(make_pair(keys[i] / 16, (int)i));
+    }
+    moves += skewed.rebalance();
+  }
+  size_t largest = 0;
+  for (size_t s = 0; s < skewed.shardCount(); s++){
+    largest = std::max(largest, skewed.shardSize(s));
+  }
+  cout << "skewed keys: " << moves << " rebalances, largest shard " << largest
+       << " of " << skewed.size() << " items" << endl;
+}
+
+// An LSMTree on disk (files bst-bench-lsm-* in the working directory, all
+// removed again by the time main is done with them): inserts with
+// background compaction, point lookups from the runs, a full scan and the
+// write amplification the inserts cost.
+void benchLSM(const vector<int>& keys, size_t memtableBytes)
+{
+  size_t n = keys.size();
+  LSMOptions options;
+  options.memtableBytes = memtableBytes;
+  LSMTree<int, int> store("bst-bench-lsm", options);
+  store.clear();
+  string name = "LSMTree (" + to_string(memtableBytes >> 10) + " KiB memtable)";
+
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < n; i++){
+    store.insert(make_pair(keys[i], (int)i));
+  }
+  store.flush();
+  store.compact();
+  report(name + " insert", n, elapsedSeconds(start));
+
+  size_t lookups = n / 10;
+  long long sum = 0;
+  int value;
+  start = Clock::now();
+  for (size_t i = 0; i < lookups; i++){
+    if (store.find(keys[(i * 7919) % n], value)){
+      sum += value;
+    }
+  }
+  report(name + " find", lookups, elapsedSeconds(start));
+
+  size_t seen = 0;
+  start = Clock::now();
+  store.scan(INT_MIN, INT_MAX, [&seen](const int&, const int&) { seen++; });
+  report(name + " scan", seen, elapsedSeconds(start));
+
+  LSMStats stats = store.stats();
+  cout << "  " << stats.flushes << " flushes, " << stats.compactions << " compactions, write amplification "
+       << fixed << setprecision(2) << stats.writeAmplification() << endl;
+  store.clear();
+  doNotOptimize(sum);
+  if (seen != n){
+    cout << "LSMTree scan saw " << seen << " items" << endl;
+  }
+}
+
+// Loads keys[from, n) into a tree already holding keys[0, from), one
+// insert at a time with rebalancing, then again in bulk mode, where the
+// time includes endBulk.
+template<typename Tree>
+void benchBulkLoad(const string& name, const vector<int>& keys, size_t from)
+{
+  size_t n = keys.size();
+  {
+    Tree tree;
+    for (size_t i = 0; i < from; i++){
+      tree.insert(make_pair(keys[i], (int)i));
+    }
+    Clock::time_point start = Clock::now();
+    for (size_t i = from; i < n; i++){
+      tree.insert(make_pair(keys[i], (int)i));
+    }
+    report(name + " insert", n - from, elapsedSeconds(start));
+  }
+  {
+    Tree tree;
+    for (size_t i = 0; i < from; i++){
+      tree.insert(make_pair(keys[i], (int)i));
+    }
+    Clock::time_point start = Clock::now();
+    tree.beginBulk();
+    for (size_t i = from; i < n; i++){
+      tree.insert(make_pair(keys[i], (int)i));
+    }
+    tree.endBulk();
+    report(name + " bulk", n - from, elapsedSeconds(start));
+  }
+}
+
+// Copies a populated tree three ways: re-inserting its items in key
+// order (with the end() hint), buildSorted from an array of them, and
+// clone(), which copies the shape without comparisons or rotations.
+template<typename Tree>
+void benchClone(const string& name, const vector<int>& keys)
+{
+  size_t n = keys.size();
+  Tree tree;
+  for (size_t i = 0; i < n; i++){
+    tree.insert(make_pair(keys[i], (int)i));
+  }
+  {
+    Clock::time_point start = Clock::now();
+    Tree copy;
+    for (typename Tree::iterator it = tree.begin(); it != tree.end(); ++it){
+      copy.insert(copy.end(), *it);
+    }
+    report(name + " copy by insert(end())", n, elapsedSeconds(start));
+  }
+  {
+    Clock::time_point start = Clock::now();
+    vector<pair<const int, int> > items;
+    items.reserve(n);
+    for (typename Tree::iterator it = tree.begin(); it != tree.end(); ++it){
+      items.push_back(*it);
+    }
+    Tree copy;
+    copy.buildSorted(items.data(), items.size());
+    report(name + " copy by buildSorted", n, elapsedSeconds(start));
+  }
+  {
+    Clock::time_point start = Clock::now();
+    Tree copy = tree.clone();
+    report(name + " clone()", n, elapsedSeconds(start));
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  size_t n = 1000000;
+  if (argc > 1){
+    n = strtoul(argv[1], nullptr, 10);
+  }
+  vector<int> keys = shuffledKeys(n, 42);
+
+  cout << "sizeof(Node) = " << sizeof(Node<int, int>)
+       << ", sizeof(AVLNode) = " << sizeof(AVLNode<int, int>)
+       << ", sizeof(RBNode) = " << sizeof(RBNode<int, int>)
+       << ", sizeof(CompactAVLNode) = " << sizeof(CompactAVLNode<int, int>) << endl;
+
+  benchChurn<AVLTree<int, int> >("AVLTree", keys);
+  benchChurn<RedBlackTree<int, int> >("RedBlackTree", keys);
+
+  benchHinted("monotonic", nearlySortedKeys(n, 0, 1));
+  benchHinted("nearly monotonic (+-8)", nearlySortedKeys(n, 8, 1));
+
+  benchPopMin(keys);
+
+  benchLayout<AVLTree<int, int> >("AVLTree", keys);
+  benchLayout<CompactAVLTree<int, int> >("CompactAVLTree", keys);
+  benchLayout<ThreadedAVLTree<int, int> >("ThreadedAVLTree", keys);
+
+  benchEqualPaths(n);
+
+  benchValidate(keys);
+
+  benchAnalyze(keys);
+
+  benchExport(keys);
+
+  benchParallel(keys);
+
+  benchFindBatch(keys, 64);
+  benchFindBatch(keys, 1024);
+
+  benchAggregate(keys);
+
+  benchIntervals(n);
+
+  benchMerkleDiff(keys, 10);
+  benchMerkleDiff(keys, 1000);
+
+  benchSetMemory<int>("int", keys);
+  benchSetMemory<long long>("long long", vector<long long>(keys.begin(), keys.end()));
+
+  benchTinyMaps<AVLTree<int, int> >("100k x 8 AVLTree", 100000, 8);
+  benchTinyMaps<SmallAVLMap<int, int> >("100k x 8 SmallAVLMap<16>", 100000, 8);
+  benchTinyMaps<AVLTree<int, int> >("10k x 64 AVLTree", 10000, 64);
+  benchTinyMaps<SmallAVLMap<int, int> >("10k x 64 SmallAVLMap<16>", 10000, 64);
+
+  benchPointLookups<AVLTree<int, int> >("AVLTree", keys);
+  benchPointLookups<HashedAVLTree<int, int> >("HashedAVLTree", keys);
+
+  vector<string> longKeys = stringKeys(n, 24, 5);
+  benchStringKeys<AVLTree<string, int> >("AVLTree<string> 24+ byte keys", longKeys);
+  benchStringKeys<StringAVLTree<int> >("StringAVLTree 24+ byte keys", longKeys);
+
+  vector<string> shortKeys = stringKeys(n, 12, 6);
+  benchInternedKeys<AVLTree<string, int> >("AVLTree<string> 13-19 byte keys", shortKeys);
+  benchInternedKeys<InternedAVLTree<int> >("InternedAVLTree 13-19 byte keys", shortKeys);
+
+  benchIntegerKeys<AVLTree<int, int> >("AVLTree dense int keys", keys);
+  benchIntegerKeys<OrderedMapFor<int, int>::type>("RadixTree dense int keys", keys);
+  //an odd multiplier permutes the 32-bit values, spreading the keys out
+  vector<int> sparse(n);
+  for (size_t i = 0; i < n; i++){
+    sparse[i] = (int)((unsigned)keys[i] * 2654435761u);
+  }
+  benchIntegerKeys<AVLTree<int, int> >("AVLTree sparse int keys", sparse);
+  benchIntegerKeys<OrderedMapFor<int, int>::type>("RadixTree sparse int keys", sparse);
+
+  benchShardedWrites(keys);
+
+  benchLSM(keys, 1 << 20);
+  benchLSM(keys, 4 << 20);
+  //each store cleared its runs, which leaves only the manifest
+  std::remove("bst-bench-lsm-manifest");
+
+  benchBulkLoad<AVLTree<int, int> >("AVLTree into empty", keys, 0);
+  benchBulkLoad<AVLTree<int, int> >("AVLTree into 90% full", keys, n - n / 10);
+  benchBulkLoad<AugmentedAVLTree<int, int> >("AugmentedAVLTree into empty", keys, 0);
+  benchBulkLoad<AugmentedAVLTree<int, int> >("AugmentedAVLTree into 90% full", keys, n - n / 10);
+  vector<int> sortedKeys = nearlySortedKeys(n, 0, 1);
+  benchBulkLoad<AVLTree<int, int> >("AVLTree sorted into empty", sortedKeys, 0);
+  benchBulkLoad<AVLTree<int, int> >("AVLTree sorted into 90% full", sortedKeys, n - n / 10);
+
+  benchClone<AVLTree<int, int> >("AVLTree", keys);
+  benchClone<AugmentedAVLTree<int, int> >("AugmentedAVLTree", keys);
+
+  return 0;
+}
@@ -1,10 +1,61 @@
 #include <iostream>
 #include <map>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
 #include "bst.h"
 #include "avlbst.h"
+#include "rbbst.h"
+#include "compactavl.h"
+#include "threadedavl.h"
+#include "augmentedavl.h"
+#include "intervaltree.h"
+#include "merkleavl.h"
+#include "avlset.h"
+#include "smallmap.h"
+#include "hashedavl.h"
+#include "stringavl.h"
+#include "internedavl.h"
+#include "radixtree.h"
+#include "shardedavl.h"
+#include "lsmtree.h"
 
 using namespace std;
 
+// Black height of the subtree under n, or -1 if a red node has a red
+// child or two paths down to null have different numbers of black nodes.
+template<class Key, class Value>
+int blackHeight(RBNode<Key,Value>* n)
+{
+    if(n == nullptr) {
+        return 1;
+    }
+    if(n->isRed() && ((n->getLeft() != nullptr && n->getLeft()->isRed()) ||
+                      (n->getRight() != nullptr && n->getRight()->isRed()))) {
+        return -1;
+    }
+    int left = blackHeight(n->getLeft());
+    int right = blackHeight(n->getRight());
+    if(left < 0 || left != right) {
+        return -1;
+    }
+    return left + (n->isRed() ? 0 : 1);
+}
+
+// Takes over a RedBlackTree to check every red-black rule on it.
+template<class Key, class Value>
+class CheckedRedBlackTree : public RedBlackTree<Key,Value>
+{
+public:
+    CheckedRedBlackTree(RedBlackTree<Key,Value>&& tree) : RedBlackTree<Key,Value>(std::move(tree)) {}
+
+    bool redBlackValid() const
+    {
+        RBNode<Key,Value>* root = static_cast<RBNode<Key,Value>*>(this->root_);
+        return root == nullptr || (!root->isRed() && blackHeight(root) > 0);
+    }
+};
+
 
 int main(int argc, char *argv[])
 {
@@ -29,6 +80,17 @@ int main(int argc, char *argv[])
     cout << "Erasing b" << endl;
     bt.remove('b');
 
+    // equalPaths on Node<Key, Value> (equal-paths.h's Node clashes with
+    // bst.h's, so this overload is tested here)
+    Node<int,int> n1(1, 0, nullptr), n2(2, 0, &n1), n3(3, 0, &n1), n4(4, 0, &n3), n5(5, 0, &n2);
+    n1.setLeft(&n2);
+    n1.setRight(&n3);
+    cout << "equalPaths on Node<int,int>: " << equalPaths(&n1);
+    n3.setLeft(&n4);
+    cout << " " << equalPaths(&n1);
+    n2.setRight(&n5);
+    cout << " " << equalPaths(&n1) << endl;
+
     // AVL Tree Tests
     AVLTree<char,int> at;
     at.insert(std::make_pair('a',1));
@@ -46,6 +108,311 @@ int main(int argc, char *argv[])
     }
     cout << "Erasing b" << endl;
     at.remove('b');
+    at.insert(std::make_pair('c',3));
+    cout << "min " << at.min().first << ", max " << at.max().first << endl;
+    cout << "popMin " << at.popMin().first << ", popMax " << at.popMax().first << endl;
+    cout << (at.empty() ? "AVLTree empty" : "AVLTree not empty") << endl;
+
+    // AVL bulk load tests
+    AVLTree<int,int> bk;
+    bk.beginBulk();
+    for(int i = 0; i < 100; i++) {
+        bk.insert(std::make_pair((i * 37) % 100, 0));
+    }
+    cout << "\nBulk load pending, 7 found: " << (bk.find(7) != bk.end() ? "yes" : "no") << endl;
+    bk.remove(50);
+    for(int i = 99; i >= 0; i--) {
+        if(i != 50) {
+            bk.insert(std::make_pair(i, i * i));
+        }
+    }
+    cout << "Bulk load valid before endBulk: " << (bk.validate().ok ? "yes" : "no")
+         << ", 50 found: " << (bk.find(50) != bk.end() ? "yes" : "no") << endl;
+    bk.endBulk();
+    cout << "Bulk load valid after endBulk: " << (bk.validate().ok ? "yes" : "no")
+         << ", 99 = " << bk[99] << endl;
+
+    // Move, swap and clone tests
+    AVLTree<int,int> cl = bk.clone();
+    AVLTree<int,int> mv(std::move(bk));
+    cout << "\nClone valid: " << (cl.validate().ok ? "yes" : "no") << ", 99 = " << cl[99]
+         << ", moved-from empty: " << (bk.empty() ? "yes" : "no") << endl;
+    bk.insert(std::make_pair(7, 7));
+    bk.swap(mv);
+    cout << "After swap min " << bk.min().first << ", other min " << mv.min().first << endl;
+    HashedAVLTree<int,int> hm;
+    ThreadedAVLTree<int,int> tm;
+    for(int i = 0; i < 100; i++) {
+        hm.insert(std::make_pair(i, i));
+        tm.insert(std::make_pair(i, i));
+    }
+    HashedAVLTree<int,int> hmv(std::move(hm));
+    ThreadedAVLTree<int,int> tmv;
+    tmv = std::move(tm);
+    int threadedCount = 0;
+    for(ThreadedAVLTree<int,int>::iterator it = tmv.begin(); it != tmv.end(); ++it) {
+        threadedCount++;
+    }
+    cout << "Moved hashed tree has 42: " << (hmv.contains(42) ? "yes" : "no")
+         << ", moved threaded tree iterates " << threadedCount << " items" << endl;
+    TreeStats hashedStats = hmv.analyze();
+    cout << "Hashed tree memory counts its index: "
+         << (hashedStats.memoryBytes - hashedStats.nodes * hashedStats.nodeBytes > sizeof(hmv) ? "yes" : "no") << endl;
+
+    // Red Black Tree tests
+    RedBlackTree<char,int> rt;
+    rt.insert(std::make_pair('a',1));
+    rt.insert(std::make_pair('b',2));
+    rt.insert(std::make_pair('c',3));
+
+    cout << "\nRedBlackTree contents:" << endl;
+    for(RedBlackTree<char,int>::iterator it = rt.begin(); it != rt.end(); ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+    if(rt.find('b') != rt.end()) {
+        cout << "Found b" << endl;
+    }
+    else {
+        cout << "Did not find b" << endl;
+    }
+    cout << "Erasing b" << endl;
+    rt.remove('b');
+    rt.print();
+    RedBlackTree<int,int> rb;
+    for(int i = 0; i < 667; i++) {
+        rb.insert(std::make_pair((i * 337) % 667, i));
+    }
+    CheckedRedBlackTree<int,int> rbc(rb.clone());
+    bool cloneValid = rbc.redBlackValid();
+    for(int i = 0; i < 667; i += 2) {
+        rbc.remove(i);
+        cloneValid = cloneValid && rbc.redBlackValid();
+    }
+    CheckedRedBlackTree<int,int> rbo(std::move(rb));
+    cout << "RedBlackTree clone valid through removes: " << (cloneValid ? "yes" : "no")
+         << ", original still valid: " << (rbo.redBlackValid() ? "yes" : "no") << endl;
+
+    // Compact AVL Tree tests
+    CompactAVLTree<char,int> ct;
+    ct.insert(std::make_pair('a',1));
+    ct.insert(std::make_pair('b',2));
+    ct.insert(std::make_pair('c',3));
+
+    cout << "\nCompactAVLTree contents:" << endl;
+    for(CompactAVLTree<char,int>::iterator it = ct.begin(); it != ct.end(); ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+    cout << "Erasing b" << endl;
+    ct.remove('b');
+    cout << (ct.find('b') == ct.end() ? "Did not find b" : "Found b") << endl;
+    cout << (ct.isBalanced() ? "CompactAVLTree balanced" : "CompactAVLTree not balanced") << endl;
+    CompactAVLTree<char,int> cmv(std::move(ct));
+    cout << "Moved CompactAVLTree has c: " << (cmv.find('c') != cmv.end() ? "yes" : "no")
+         << ", moved-from empty: " << (ct.empty() ? "yes" : "no") << endl;
+
+    // Threaded AVL Tree tests
+    ThreadedAVLTree<char,int> tt;
+    tt.insert(std::make_pair('a',1));
+    tt.insert(std::make_pair('b',2));
+    tt.insert(std::make_pair('c',3));
+    tt.remove('b');
+
+    cout << "\nThreadedAVLTree contents in reverse:" << endl;
+    for(ThreadedAVLTree<char,int>::iterator it = tt.find('c'); it != tt.end(); --it) {
+        cout << it->first << " " << it->second << endl;
+    }
+    cout << (tt.validate().ok ? "ThreadedAVLTree valid" : "ThreadedAVLTree not valid") << endl;
+    tt.analyze().writeJson(cout);
+    cout << endl;
+    tt.exportTree(cout, EXPORT_JSON);
+    cout << "Sum of values a..z: "
+         << parallel_reduce(tt, 'a', 'z', 0, [](int x, int y) { return x + y; }) << endl;
+
+    // Work pool tests: back-to-back small batches, where a worker still
+    // draining one batch can pick up tasks of the next
+    WorkStealingPool smallPool(4);
+    std::atomic<long> poolRuns(0);
+    std::vector<WorkStealingPool::Task> poolTasks(3, [&poolRuns]() { poolRuns++; });
+    for(int i = 0; i < 50000; i++) {
+        smallPool.run(poolTasks);
+    }
+    cout << "WorkStealingPool ran " << poolRuns << " of " << 3 * 50000 << " tasks" << endl;
+    AVLTree<int,int> pt;
+    for(int i = 0; i < 100; i++) {
+        pt.insert(std::make_pair(i, 1));
+    }
+    long reduced = 0;
+    for(int i = 0; i < 20000; i++) {
+        reduced += parallel_reduce(pt, 0, 100, 0, [](int x, int y) { return x + y; }, smallPool);
+        reduced += parallel_reduce(pt, 0, 100, 0, [](int x, int y) { return x + y; });
+    }
+    cout << "Repeated parallel_reduce total " << reduced << " (expected " << 2 * 20000 * 100 << ")" << endl;
+
+    // Augmented AVL Tree tests
+    AugmentedAVLTree<char,int> st;
+    st.insert(std::make_pair('a',1));
+    st.insert(std::make_pair('b',2));
+    st.insert(std::make_pair('c',3));
+    st.insert(std::make_pair('d',4));
+    cout << "\nAugmentedAVLTree sum of [b, d): " << st.aggregate('b', 'd') << endl;
+    st.update('c', 30);
+    st.remove('b');
+    cout << "After update c=30 and erasing b, sum of [a, z): " << st.aggregate('a', 'z') << endl;
+    std::vector<std::pair<const char,int> > sortedItems;
+    for(char c = 'a'; c <= 'z'; ++c) {
+        sortedItems.push_back(std::make_pair(c, 1));
+    }
+    st.buildSorted(&sortedItems[0], sortedItems.size());
+    cout << "After buildSorted a..z, sum of [e, j): " << st.aggregate('e', 'j')
+         << ", total " << st.aggregate() << endl;
+
+    // Interval Tree tests
+    IntervalTree<int,char> it;
+    it.insert(1, 5, 'a');
+    it.insert(3, 8, 'b');
+    it.insert(10, 12, 'c');
+    cout << "\nIntervals overlapping [4, 10]:" << endl;
+    std::vector<IntervalTree<int,char>::iterator> hits = it.overlapping(4, 10);
+    for(size_t i = 0; i < hits.size(); ++i) {
+        cout << hits[i]->first << " " << hits[i]->second << endl;
+    }
+    cout << "Intervals containing 6: " << it.stabbing(6).size() << endl;
+
+    // Merkle AVL Tree tests
+    MerkleAVLTree<char,int> mt1, mt2;
+    for(char c = 'a'; c <= 'g'; ++c) {
+        mt1.insert(std::make_pair(c, c - 'a'));
+    }
+    for(char c = 'g'; c >= 'a'; --c) {
+        mt2.insert(std::make_pair(c, c - 'a'));
+    }
+    cout << "\nMerkleAVLTree replicas " << (mt1.digest() == mt2.digest() ? "match" : "differ") << endl;
+    mt2.update('c', 20);
+    mt2.remove('e');
+    mt2.insert(std::make_pair('h', 7));
+    std::vector<char> changed = mt1.diff(mt2);
+    cout << "Keys that differ:";
+    for(size_t i = 0; i < changed.size(); ++i) {
+        cout << " " << changed[i];
+    }
+    cout << endl;
+
+    // AVL Set tests
+    AVLSet<char> as;
+    as.insert('m');
+    as.insert('c');
+    as.insert('x');
+    cout << "\nInserting c again " << (as.insert('c') ? "added it" : "was a no-op") << endl;
+    as.erase('m');
+    cout << "AVLSet contents:";
+    for(AVLSet<char>::iterator it = as.begin(); it != as.end(); ++it) {
+        cout << " " << *it;
+    }
+    cout << endl << "Contains m: " << (as.contains('m') ? "yes" : "no") << ", size " << as.size() << endl;
+
+    // Small map tests
+    SmallAVLMap<char,int,2> sm;
+    sm.insert(std::make_pair('b',2));
+    sm.insert(std::make_pair('a',1));
+    cout << "\nSmallAVLMap with 2 items is " << (sm.isInline() ? "inline" : "a tree") << endl;
+    sm.insert(std::make_pair('c',3));
+    cout << "SmallAVLMap with 3 items is " << (sm.isInline() ? "inline" : "a tree") << ":" << endl;
+    for(SmallAVLMap<char,int,2>::iterator it = sm.begin(); it != sm.end(); ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+
+    // Hashed AVL Tree tests
+    HashedAVLTree<char,int> ht;
+    ht.insert(std::make_pair('d',4));
+    ht.insert(std::make_pair('a',1));
+    ht.insert(std::make_pair('f',6));
+    ht.remove('a');
+    cout << "\nHashedAVLTree f = " << ht['f'] << ", contains a: " << (ht.contains('a') ? "yes" : "no")
+         << ", first key >= e: " << ht.lowerBound('e')->first << endl;
+
+    // String AVL Tree tests
+    StringAVLTree<int> wt;
+    wt.insert(std::make_pair(std::string("interning"), 1));
+    wt.insert(std::make_pair(std::string("internal"), 2));
+    wt.insert(std::make_pair(std::string("intern"), 3));
+    wt.insert(std::make_pair(std::string("apple"), 4));
+    wt.remove("internal");
+    cout << "\nStringAVLTree contents:" << endl;
+    for(StringAVLTree<int>::iterator it = wt.begin(); it != wt.end(); ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+    cout << "interning = " << wt["interning"] << endl;
+
+    // Interned AVL Tree tests
+    InternedAVLTree<int> nt;
+    std::string temp = "transient";
+    nt.insert(temp, 1);
+    nt.insert("durable", 2);
+    temp = "overwritten";
+    cout << "\nInternedAVLTree contents:" << endl;
+    for(InternedAVLTree<int>::iterator it = nt.begin(); it != nt.end(); ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+    cout << "Contains transient: " << (nt.contains("transient") ? "yes" : "no") << endl;
+
+    // Radix Tree tests
+    RadixTree<int,char> xt;
+    xt.insert(std::make_pair(300,'c'));
+    xt.insert(std::make_pair(-5,'a'));
+    xt.insert(std::make_pair(7,'b'));
+    xt.insert(std::make_pair(70000,'d'));
+    xt.remove(7);
+    cout << "\nRadixTree contents:" << endl;
+    for(RadixTree<int,char>::iterator it = xt.begin(); it != xt.end(); ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+    cout << "300 = " << xt[300] << ", size " << xt.size() << endl;
+
+    // Sharded AVL Tree tests
+    ShardedAVLTree<char,int> sh(std::vector<char>(1,'m'));
+    sh.insert(std::make_pair('x',24));
+    sh.insert(std::make_pair('c',3));
+    sh.insert(std::make_pair('a',1));
+    sh.insert(std::make_pair('e',5));
+    sh.insert(std::make_pair('p',16));
+    cout << "\nShardedAVLTree shard sizes: " << sh.shardSize(0) << " " << sh.shardSize(1) << endl;
+    cout << "After rebalance: " << sh.rebalance(1.0) << ", shard sizes: "
+         << sh.shardSize(0) << " " << sh.shardSize(1) << endl;
+    for(ShardedAVLTree<char,int>::iterator it = sh.begin(); it != sh.end(); ++it) {
+        cout << it->first << " " << it->second << endl;
+    }
+
+    // LSM Tree tests, in a scratch directory that is removed afterwards
+    char lsmDir[] = "/tmp/bst-test-lsm-XXXXXX";
+    if(mkdtemp(lsmDir) == nullptr) {
+        cout << "Cannot create a directory for the LSMTree tests" << endl;
+        return 1;
+    }
+    std::string lsmPrefix = std::string(lsmDir) + "/lsm";
+    {
+        LSMOptions lsmOptions;
+        lsmOptions.background = false;
+        LSMTree<int,std::string> lt(lsmPrefix, lsmOptions);
+        lt.insert(std::make_pair(3, std::string("three")));
+        lt.insert(std::make_pair(1, std::string("one")));
+        lt.flush();
+        lt.insert(std::make_pair(2, std::string("two")));
+        lt.remove(3);
+        lt.flush();
+        lt.insert(std::make_pair(4, std::string("four")));
+        cout << "\nLSMTree runs before compaction: " << lt.stats().runs << endl;
+        lt.compact();
+        cout << "LSMTree runs after compaction: " << lt.stats().runs << ", contents:" << endl;
+        lt.scan(0, 10, [](const int& key, const std::string& value) {
+            cout << key << " " << value << endl;
+        });
+        cout << "Contains 3: " << (lt.contains(3) ? "yes" : "no") << ", 2 = " << lt[2] << endl;
+        lt.clear();
+    }
+    std::remove((lsmPrefix + "-manifest").c_str());
+    if(rmdir(lsmDir) != 0) {
+        cout << "LSMTree left files in " << lsmDir << endl;
+    }
 
     return 0; 
 }
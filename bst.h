@@ -5,6 +5,12 @@
 #include <exception>
 #include <cstdlib>
 #include <utility>
+#include <type_traits>
+#include <vector>
+#include "equal-paths-generic.h"
+#include "tree-check.h"
+#include "tree-stats.h"
+#include "tree-export.h"
 
 /**
  * A templated class for a Node in a search tree.
@@ -30,6 +36,11 @@ public:
     virtual Node<Key, Value>* getLeft() const;
     virtual Node<Key, Value>* getRight() const;
 
+    // In-order neighbours. These walk the tree, but can be overridden by
+    // nodes that keep direct links (see ThreadedAVLNode).
+    virtual Node<Key, Value>* getSuccessor() const;
+    virtual Node<Key, Value>* getPredecessor() const;
+
     void setParent(Node<Key, Value>* parent);
     void setLeft(Node<Key, Value>* left);
     void setRight(Node<Key, Value>* right);
@@ -144,6 +155,52 @@ Node<Key, Value>* Node<Key, Value>::getRight() const
     return right_;
 }
 
+/**
+* Returns the next node in key order, or nullptr if this is the largest.
+* That is the leftmost node of the right subtree, or otherwise the first
+* ancestor that has this node in its left subtree.
+*/
+template<typename Key, typename Value>
+Node<Key, Value>* Node<Key, Value>::getSuccessor() const
+{
+    Node<Key, Value>* current = getRight();
+    if (current != nullptr){
+      while (current->getLeft() != nullptr){
+        current = current->getLeft();
+      }
+      return current;
+    }
+    const Node<Key, Value>* child = this;
+    current = getParent();
+    while (current != nullptr && current->getLeft() != child){
+      child = current;
+      current = current->getParent();
+    }
+    return current;
+}
+
+/**
+* Returns the previous node in key order, or nullptr if this is the smallest.
+*/
+template<typename Key, typename Value>
+Node<Key, Value>* Node<Key, Value>::getPredecessor() const
+{
+    Node<Key, Value>* current = getLeft();
+    if (current != nullptr){
+      while (current->getRight() != nullptr){
+        current = current->getRight();
+      }
+      return current;
+    }
+    const Node<Key, Value>* child = this;
+    current = getParent();
+    while (current != nullptr && current->getRight() != child){
+      child = current;
+      current = current->getParent();
+    }
+    return current;
+}
+
 /**
 * A setter for setting the parent of a node.
 */
@@ -186,6 +243,17 @@ void Node<Key, Value>::setValue(const Value& value)
   ---------------------------------------
 */
 
+/**
+* Names a type only when Other is a tree derived from Tree (and not Tree
+* itself). Trees that others derive from delete their moves and swap for
+* such types, since a derived tree's own state would be sliced off; each
+* derived tree moves and swaps with its own type instead.
+*/
+template <class Tree, class Other>
+using EnableIfDerivedTree = typename std::enable_if<
+    std::is_base_of<Tree, typename std::decay<Other>::type>::value &&
+    !std::is_same<Tree, typename std::decay<Other>::type>::value>::type;
+
 /**
 * A templated unbalanced binary search tree.
 */
@@ -194,16 +262,37 @@ class BinarySearchTree
 {
 public:
     BinarySearchTree(); //TODO
+    BinarySearchTree(BinarySearchTree&& other) noexcept;
+    BinarySearchTree& operator=(BinarySearchTree&& other) noexcept;
+    template <class Tree, class = EnableIfDerivedTree<BinarySearchTree, Tree> >
+    BinarySearchTree(Tree&& other) = delete;
+    template <class Tree, class = EnableIfDerivedTree<BinarySearchTree, Tree> >
+    BinarySearchTree& operator=(Tree&& other) = delete;
     virtual ~BinarySearchTree(); //TODO
+    void swap(BinarySearchTree& other) noexcept;
+    template <class Tree, class = EnableIfDerivedTree<BinarySearchTree, Tree> >
+    void swap(Tree& other) = delete;
+    BinarySearchTree clone() const;
     virtual void insert(const std::pair<const Key, Value>& keyValuePair); //TODO
     virtual void remove(const Key& key); //TODO
-    void clear(); //TODO
+    virtual void clear(); //TODO
     bool isBalanced() const; //TODO
+    TreeCheckResult validate(unsigned checks = CHECK_ORDER) const;
+    TreeCheckResult validate(unsigned checks, WorkStealingPool& pool) const;
+    TreeStats analyze() const;
+    TreeStats analyze(size_t samples, unsigned seed = 1) const;
+    void exportTree(std::ostream& out, TreeExportFormat format = EXPORT_DOT,
+                    const TreeExportOptions& options = TreeExportOptions()) const;
     void print() const;
+    void print(int height) const;
+    void printAround(const Key& key) const;
+    void printAround(const Key& key, int height) const;
     bool empty() const;
 
     template<typename PPKey, typename PPValue>
     friend void prettyPrintBST(BinarySearchTree<PPKey, PPValue> & tree);
+    template<typename PKey, typename PValue>
+    friend class TreePartition;
 public:
     /**
     * An internal iterator class for traversing the contents of the BST.
@@ -220,6 +309,7 @@ public:
         bool operator!=(const iterator& rhs) const;
 
         iterator& operator++();
+        iterator& operator--();
 
     protected:
         friend class BinarySearchTree<Key, Value>;
@@ -231,28 +321,64 @@ public:
     iterator begin() const;
     iterator end() const;
     iterator find(const Key& key) const;
+    iterator lowerBound(const Key& key) const;
+    void findBatch(const std::vector<Key>& keys, std::vector<iterator>& out) const;
     Value& operator[](const Key& key);
     Value const & operator[](const Key& key) const;
+    const std::pair<const Key, Value>& min() const;
+    const std::pair<const Key, Value>& max() const;
+    std::pair<Key, Value> popMin();
+    std::pair<Key, Value> popMax();
 
 protected:
     // Mandatory helper functions
     Node<Key, Value>* internalFind(const Key& k) const; // TODO
     Node<Key, Value> *getSmallestNode() const;  // TODO
+    Node<Key, Value> *getLargestNode() const;
     static Node<Key, Value>* predecessor(Node<Key, Value>* current); // TODO
+    static void prefetchNode(const Node<Key, Value>* n);
     // Note:  static means these functions don't have a "this" pointer
     //        and instead just use the input argument.
 
     // Provided helper functions
     virtual void printRoot (Node<Key, Value> *r) const;
+    void printRoot (Node<Key, Value> *r, int height) const;
     virtual void nodeSwap( Node<Key,Value>* n1, Node<Key,Value>* n2) ;
+    virtual void removeNode(Node<Key, Value>* n);
+    // size of the node type this tree allocates, for analyze()
+    virtual size_t nodeBytes() const;
+    // size of the tree object itself plus anything it owns outside the
+    // nodes (tables, arenas, ...), for analyze()
+    virtual size_t treeBytes() const;
 
     // Add helper functions here
     void deleteNodes(Node<Key, Value>* n);
+    // iterator's node constructor and current_ are only visible to this
+    // class, so derived trees go through these to build/inspect iterators
+    static iterator makeIterator(Node<Key, Value>* n);
+    static Node<Key, Value>* iteratorNode(const iterator& it);
+    // called right after linking a new node, and right before unlinking a
+    // node with at most one child. The base versions keep leftmost_ and
+    // rightmost_ current; trees that keep more per-node state extend them
+    virtual void nodeLinked(Node<Key, Value>* n);
+    virtual void nodeUnlinking(Node<Key, Value>* n);
+    // called after insert overwrites the value of an existing node
+    virtual void nodeUpdated(Node<Key, Value>* n);
+    // copies src's nodes into this empty tree, keeping the shape
+    virtual void cloneFrom(const BinarySearchTree<Key, Value>& src);
+    // allocates an unlinked copy of src, including any per-node state
+    // (balance, colour, ...) that the key and value do not determine
+    virtual Node<Key, Value>* cloneNode(const Node<Key, Value>* src);
+    // called by cloneFrom right after linking a copy of src, which is a
+    // leaf at that point; the base version is nodeLinked(copy)
+    virtual void nodeCloned(Node<Key, Value>* copy, const Node<Key, Value>* src);
     int checkBalance(Node<Key, Value>* n) const; 
 
 protected:
     Node<Key, Value>* root_;
-    // You should not need other data members
+    // cached so begin(), min(), max() and the pops never walk the tree
+    Node<Key, Value>* leftmost_;
+    Node<Key, Value>* rightmost_;
 };
 
 /*
@@ -347,34 +473,34 @@ BinarySearchTree<Key, Value>::iterator::operator++()
     //DONE
     //current is the Node<key, value> pointer
 
-    //sucessor is right most node of right subtree
-    //otherwise, is parent
+    //sucessor is left most node of right subtree
+    //otherwise, is the first ancestor we reach from its left subtree
     //if node is the rightmost node, then no sucessor
+    //(the walk lives in Node so threaded nodes can replace it with a link)
 
     if (current_ == nullptr){
       return *this;
     }
-    //there is a right subtree
-    if (current_->getRight() != nullptr){
-      current_ = current_->getRight();
-      while (current_->getLeft() != nullptr){
-        current_ = current_->getLeft();
-      }
-    }
-    //no right subtree
-    else {
-      Node<Key, Value>* parent = current_->getParent();
-      while (parent != nullptr && parent->getLeft() != current_){ //current is in rightsubtree of parent so parent < current
-        current_ = parent;
-        parent = parent->getParent();
-      }
-      current_ = parent; //either nullptr or the current node will be a predesessor of parent, so parent is the succesor of current
-    }
-
+    current_ = current_->getSuccessor();
     return *this; 
   
 }
 
+/**
+* Moves the iterator to the previous item in order. Stepping back from
+* the smallest item gives end(); end() itself cannot be decremented.
+*/
+template<class Key, class Value>
+typename BinarySearchTree<Key, Value>::iterator&
+BinarySearchTree<Key, Value>::iterator::operator--()
+{
+    if (current_ == nullptr){
+      return *this;
+    }
+    current_ = current_->getPredecessor();
+    return *this;
+}
+
 
 /*
 -------------------------------------------------------------
@@ -393,13 +519,62 @@ Begin implementations for the BinarySearchTree class.
 */
 template<class Key, class Value>
 BinarySearchTree<Key, Value>::BinarySearchTree() :
-  root_(nullptr)
+  root_(nullptr), leftmost_(nullptr), rightmost_(nullptr)
 {
     // TODO
     // DONE initializer list
 
 }
 
+/**
+* Takes over other's nodes in O(1), leaving other empty.
+*/
+template<typename Key, typename Value>
+BinarySearchTree<Key, Value>::BinarySearchTree(BinarySearchTree&& other) noexcept :
+  root_(other.root_), leftmost_(other.leftmost_), rightmost_(other.rightmost_)
+{
+    other.root_ = nullptr;
+    other.leftmost_ = nullptr;
+    other.rightmost_ = nullptr;
+}
+
+/**
+* Frees this tree's nodes and takes over other's, leaving other empty.
+*/
+template<typename Key, typename Value>
+BinarySearchTree<Key, Value>& BinarySearchTree<Key, Value>::operator=(BinarySearchTree&& other) noexcept
+{
+    BinarySearchTree<Key, Value> old(std::move(other));
+    swap(old);
+    return *this;
+}
+
+/**
+* Exchanges the contents of two trees of the same type in O(1). Trees
+* with state of their own beyond the nodes extend this. Both trees must
+* really be BinarySearchTrees: a derived tree swapped through a base
+* reference would lose its own state.
+*/
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::swap(BinarySearchTree& other) noexcept
+{
+    std::swap(root_, other.root_);
+    std::swap(leftmost_, other.leftmost_);
+    std::swap(rightmost_, other.rightmost_);
+}
+
+/**
+* Returns a deep copy with exactly this tree's shape, in O(n) without
+* comparing keys. Derived trees return their own type the same way.
+*/
+template<typename Key, typename Value>
+BinarySearchTree<Key, Value> BinarySearchTree<Key, Value>::clone() const
+{
+    BinarySearchTree<Key, Value> copy;
+    copy.cloneFrom(*this);
+    return copy;
+}
+
 template<typename Key, typename Value>
 BinarySearchTree<Key, Value>::~BinarySearchTree()
 {
@@ -461,6 +636,75 @@ BinarySearchTree<Key, Value>::find(const Key & k) const
     return it;
 }
 
+/**
+* Returns an iterator to the first item whose key is not less than key,
+* or the end iterator if every key is less.
+*/
+template<class Key, class Value>
+typename BinarySearchTree<Key, Value>::iterator
+BinarySearchTree<Key, Value>::lowerBound(const Key& key) const
+{
+    Node<Key, Value>* result = nullptr;
+    Node<Key, Value>* curr = root_;
+    while (curr != nullptr){
+      if (curr->getKey() < key){
+        curr = curr->getRight();
+      }
+      else {
+        result = curr;
+        curr = curr->getLeft();
+      }
+    }
+    return iterator(result);
+}
+
+/**
+* Looks up every key in keys, leaving out[i] as find(keys[i]). Instead of
+* one descent at a time, up to FIND_BATCH_LANES descents advance in turn,
+* one level each, and every step prefetches the node the next step will
+* read. A single descent is a chain of dependent cache misses; interleaving
+* keeps several of those misses in flight at once.
+*/
+template<class Key, class Value>
+void BinarySearchTree<Key, Value>::findBatch(const std::vector<Key>& keys, std::vector<iterator>& out) const
+{
+    static const size_t FIND_BATCH_LANES = 16;
+
+    out.assign(keys.size(), end());
+    Node<Key, Value>* lane[FIND_BATCH_LANES];
+    size_t laneKey[FIND_BATCH_LANES];
+    size_t lanes = 0;
+    size_t next = 0;
+
+    //fill the lanes, then keep each one busy until the keys run out
+    while (lanes < FIND_BATCH_LANES && next < keys.size()){
+      lane[lanes] = root_;
+      laneKey[lanes++] = next++;
+    }
+    while (lanes > 0){
+      for (size_t i = 0; i < lanes; ){
+        Node<Key, Value>* current = lane[i];
+        const Key& key = keys[laneKey[i]];
+        if (current != nullptr && !(key == current->getKey())){
+          current = (key < current->getKey()) ? current->getLeft() : current->getRight();
+          prefetchNode(current);
+          lane[i++] = current;
+          continue;
+        }
+        //this lane's descent is over: record it and start the next key
+        out[laneKey[i]] = iterator(current);
+        if (next < keys.size()){
+          lane[i] = root_;
+          laneKey[i++] = next++;
+        }
+        else {
+          lane[i] = lane[--lanes];
+          laneKey[i] = laneKey[lanes];
+        }
+      }
+    }
+}
+
 /**
  * @precondition The key exists in the map
  * Returns the value associated with the key
@@ -480,6 +724,55 @@ Value const & BinarySearchTree<Key, Value>::operator[](const Key& key) const
     return curr->getValue();
 }
 
+/**
+ * @precondition The tree is not empty
+ * Returns the item with the smallest key in O(1)
+ */
+template<class Key, class Value>
+const std::pair<const Key, Value>& BinarySearchTree<Key, Value>::min() const
+{
+    if(leftmost_ == nullptr) throw std::out_of_range("Empty tree");
+    return leftmost_->getItem();
+}
+
+/**
+ * @precondition The tree is not empty
+ * Returns the item with the largest key in O(1)
+ */
+template<class Key, class Value>
+const std::pair<const Key, Value>& BinarySearchTree<Key, Value>::max() const
+{
+    if(rightmost_ == nullptr) throw std::out_of_range("Empty tree");
+    return rightmost_->getItem();
+}
+
+/**
+ * @precondition The tree is not empty
+ * Removes and returns the item with the smallest key. The node is found in
+ * O(1) and unlinked directly, without a search from the root.
+ */
+template<class Key, class Value>
+std::pair<Key, Value> BinarySearchTree<Key, Value>::popMin()
+{
+    if(leftmost_ == nullptr) throw std::out_of_range("Empty tree");
+    std::pair<Key, Value> item(leftmost_->getKey(), leftmost_->getValue());
+    removeNode(leftmost_);
+    return item;
+}
+
+/**
+ * @precondition The tree is not empty
+ * Removes and returns the item with the largest key.
+ */
+template<class Key, class Value>
+std::pair<Key, Value> BinarySearchTree<Key, Value>::popMax()
+{
+    if(rightmost_ == nullptr) throw std::out_of_range("Empty tree");
+    std::pair<Key, Value> item(rightmost_->getKey(), rightmost_->getValue());
+    removeNode(rightmost_);
+    return item;
+}
+
 /**
 * An insert method to insert into a Binary Search Tree.
 * The tree will not remain balanced when inserting.
@@ -497,6 +790,7 @@ void BinarySearchTree<Key, Value>::insert(const std::pair<const Key, Value> &key
     // If the tree is empty crate new
     if (root_ == nullptr) {
         root_ = new Node<Key, Value>(key, value, nullptr);
+        nodeLinked(root_);
         return;
     }
 
@@ -510,6 +804,7 @@ void BinarySearchTree<Key, Value>::insert(const std::pair<const Key, Value> &key
         //if key exists, update value
         if (key == current->getKey()) {
             current->setValue(value);
+            nodeUpdated(current);
             return;
         }
 
@@ -530,6 +825,7 @@ void BinarySearchTree<Key, Value>::insert(const std::pair<const Key, Value> &key
     else {
         parent->setRight(newNode);
     }
+    nodeLinked(newNode);
 }
 
 
@@ -548,7 +844,15 @@ void BinarySearchTree<Key, Value>::remove(const Key& key)
     if (nodeToRemove == nullptr){
       return;
     }
+    removeNode(nodeToRemove);
+}
 
+/**
+* Unlinks and deletes a node that is known to be in the tree.
+*/
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::removeNode(Node<Key, Value>* nodeToRemove)
+{
     //2 child case
     if (nodeToRemove->getLeft() != nullptr&& nodeToRemove->getRight() != nullptr){
       Node<Key, Value>* pred = predecessor(nodeToRemove);
@@ -566,6 +870,7 @@ void BinarySearchTree<Key, Value>::remove(const Key& key)
     //child->setParent(nodeToRemove.getParent()); 
 
     //update parent/child pointers
+    nodeUnlinking(nodeToRemove);
     Node<Key, Value>* parent = nodeToRemove->getParent(); 
     //check for case where nodeToRemove has no parent i.e. root
     if (parent == nullptr){
@@ -592,6 +897,24 @@ void BinarySearchTree<Key, Value>::remove(const Key& key)
 
 
 
+/**
+* Hints the cache that n is about to be read. A node can straddle two
+* lines, so both ends are requested. A no-op on compilers without the
+* builtin, and for nullptr.
+*/
+template<class Key, class Value>
+void BinarySearchTree<Key, Value>::prefetchNode(const Node<Key, Value>* n)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    if (n != nullptr){
+      __builtin_prefetch(n);
+      __builtin_prefetch(reinterpret_cast<const char*>(n) + sizeof(Node<Key, Value>) - 1);
+    }
+#else
+    (void)n;
+#endif
+}
+
 template<class Key, class Value>
 Node<Key, Value>*
 BinarySearchTree<Key, Value>::predecessor(Node<Key, Value>* current)
@@ -634,19 +957,114 @@ void BinarySearchTree<Key, Value>::clear()
   //trees have no cycles, so can implement recursively 
   deleteNodes(root_);
   root_ = nullptr; 
+  leftmost_ = nullptr;
+  rightmost_ = nullptr;
 }
 
+/**
+* Frees a subtree without recursing, so that a long chain (which sorted
+* inserts leave in a plain BinarySearchTree) cannot overflow the stack:
+* each left child is rotated up until the top node has none, then the top
+* is freed and its right subtree taken next. O(n) time and O(1) space.
+*/
 template<typename Key, typename Value> 
 void BinarySearchTree<Key, Value>::deleteNodes(Node<Key, Value>* node){
-  if (node == nullptr){
-    return; 
+  while (node != nullptr){
+    Node<Key, Value>* left = node->getLeft();
+    if (left != nullptr){
+      node->setLeft(left->getRight());
+      left->setRight(node);
+      node = left;
+    }
+    else {
+      Node<Key, Value>* right = node->getRight();
+      delete node;
+      node = right;
+    }
   }
-  deleteNodes(node->getLeft());
-  deleteNodes(node->getRight());
+}
+
+
+/**
+* Walks src in pre-order with an explicit stack (src may be arbitrarily
+* deep) and hangs each copy on the side its original hangs on, so no keys
+* are compared. Each copy is a leaf when nodeCloned sees it, as after an
+* ordinary insert, so hooks that track linked nodes work unchanged.
+*/
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::cloneFrom(const BinarySearchTree<Key, Value>& src)
+{
+    struct Pending
+    {
+        const Node<Key, Value>* src;
+        Node<Key, Value>* parent;   // of the copy
+        bool left;
+    };
+
+    std::vector<Pending> stack;
+    if (src.root_ != nullptr){
+      Pending root = { src.root_, nullptr, false };
+      stack.push_back(root);
+    }
+    while (!stack.empty()){
+      Pending next = stack.back();
+      stack.pop_back();
+      Node<Key, Value>* copy = cloneNode(next.src);
+      copy->setParent(next.parent);
+      if (next.parent == nullptr){
+        root_ = copy;
+      }
+      else if (next.left){
+        next.parent->setLeft(copy);
+      }
+      else {
+        next.parent->setRight(copy);
+      }
+      nodeCloned(copy, next.src);
+
+      if (next.src->getRight() != nullptr){
+        Pending right = { next.src->getRight(), copy, false };
+        stack.push_back(right);
+      }
+      if (next.src->getLeft() != nullptr){
+        Pending left = { next.src->getLeft(), copy, true };
+        stack.push_back(left);
+      }
+    }
+}
 
-  delete node; 
+template<typename Key, typename Value>
+Node<Key, Value>* BinarySearchTree<Key, Value>::cloneNode(const Node<Key, Value>* src)
+{
+    return new Node<Key, Value>(src->getKey(), src->getValue(), nullptr);
 }
 
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::nodeCloned(Node<Key, Value>* copy, const Node<Key, Value>* src)
+{
+    (void)src;
+    nodeLinked(copy);
+}
+
+/**
+* Wraps a node pointer in an iterator (nullptr gives end()).
+*/
+template<typename Key, typename Value>
+typename BinarySearchTree<Key, Value>::iterator
+BinarySearchTree<Key, Value>::makeIterator(Node<Key, Value>* n)
+{
+    return iterator(n);
+}
+
+/**
+* Returns the node an iterator points at (nullptr for end()).
+*/
+template<typename Key, typename Value>
+Node<Key, Value>*
+BinarySearchTree<Key, Value>::iteratorNode(const iterator& it)
+{
+    return it.current_;
+}
 
 /**
 * A helper function to find the smallest node in the tree.
@@ -657,18 +1075,77 @@ BinarySearchTree<Key, Value>::getSmallestNode() const
 {
     // TODO
     // DONE
-    //smallest node is the leftmost
+    //smallest node is the leftmost, which is cached
+    return leftmost_;
+}
 
-    if (root_ == nullptr){
-      return nullptr; 
-    }
+/**
+* A helper function to find the largest node in the tree.
+*/
+template<typename Key, typename Value>
+Node<Key, Value>*
+BinarySearchTree<Key, Value>::getLargestNode() const
+{
+    //largest node is the rightmost, which is cached
+    return rightmost_;
+}
 
-    Node<Key, Value>* current = root_; 
+/**
+* A new minimum can only be linked as the left child of the old one (and
+* a new maximum as the right child of the old one), so no compares needed.
+*/
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::nodeLinked(Node<Key, Value>* n)
+{
+    if (leftmost_ == nullptr || n == leftmost_->getLeft()){
+      leftmost_ = n;
+    }
+    if (rightmost_ == nullptr || n == rightmost_->getRight()){
+      rightmost_ = n;
+    }
+}
 
-    while (current->getLeft() != nullptr){
-      current = current->getLeft();
+/**
+* When the leftmost node goes, its successor becomes the leftmost: the
+* smallest node of its right subtree if it has one, otherwise its parent.
+* The rightmost node is handled the same way with sides flipped.
+*/
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::nodeUnlinking(Node<Key, Value>* n)
+{
+    if (n == leftmost_){
+      Node<Key, Value>* next = n->getRight();
+      if (next == nullptr){
+        leftmost_ = n->getParent();
+      }
+      else {
+        while (next->getLeft() != nullptr){
+          next = next->getLeft();
+        }
+        leftmost_ = next;
+      }
     }
-    return current; 
+    if (n == rightmost_){
+      Node<Key, Value>* prev = n->getLeft();
+      if (prev == nullptr){
+        rightmost_ = n->getParent();
+      }
+      else {
+        while (prev->getRight() != nullptr){
+          prev = prev->getRight();
+        }
+        rightmost_ = prev;
+      }
+    }
+}
+
+/**
+* Nothing in the base tree depends on values.
+*/
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::nodeUpdated(Node<Key, Value>* n)
+{
+    (void)n;
 }
 
 /**
@@ -689,7 +1166,7 @@ Node<Key, Value>* BinarySearchTree<Key, Value>::internalFind(const Key& key) con
     if (key == ckey){ //found the right node
       return current; 
     }
-    if (ckey < key){
+    if (key < ckey){
       current = current->getLeft();
     }
     else {
@@ -711,6 +1188,74 @@ bool BinarySearchTree<Key, Value>::isBalanced() const
     return (checkBalance(root_) != -1); //check if it's balanced
 }
 
+/**
+ * Runs the given TreeChecks (or-ed together) in one parallel pass on the
+ * shared pool, stopping at the first violation. Plain nodes have no
+ * balance field, so CHECK_BALANCE_FIELD is ignored here.
+ */
+template<typename Key, typename Value>
+TreeCheckResult BinarySearchTree<Key, Value>::validate(unsigned checks) const
+{
+    return validate(checks, WorkStealingPool::shared());
+}
+
+template<typename Key, typename Value>
+TreeCheckResult BinarySearchTree<Key, Value>::validate(unsigned checks, WorkStealingPool& pool) const
+{
+    TreeChecker<Node<Key, Value>, Key> checker(checks);
+    return checker.run(root_, pool);
+}
+
+/**
+ * Node count, height, leaf-depth histogram, average search depth,
+ * balance-factor distribution and memory footprint, from one O(n)
+ * non-recursive pass.
+ */
+template<typename Key, typename Value>
+TreeStats BinarySearchTree<Key, Value>::analyze() const
+{
+    return collectTreeStats(root_, nodeBytes(), treeBytes());
+}
+
+/**
+ * Estimates the same stats from the given number of random descents, in
+ * O(samples * height) whatever the size of the tree. See sampleTreeStats
+ * for what is and isn't estimated.
+ */
+template<typename Key, typename Value>
+TreeStats BinarySearchTree<Key, Value>::analyze(size_t samples, unsigned seed) const
+{
+    return sampleTreeStats(root_, samples, seed, nodeBytes(), treeBytes());
+}
+
+/**
+ * Streams the whole tree (or the part the options keep) to out as DOT or
+ * JSON, in O(height) memory. See TreeExportFormat for the layout.
+ */
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::exportTree(std::ostream& out, TreeExportFormat format,
+                                              const TreeExportOptions& options) const
+{
+    TreeExporter<Node<Key, Value> > exporter(options);
+    exporter.run(root_, out, format);
+}
+
+template<typename Key, typename Value>
+size_t BinarySearchTree<Key, Value>::nodeBytes() const
+{
+    return sizeof(Node<Key, Value>);
+}
+
+/**
+* sizeof(*this) here would be the base class's size whatever the tree, so
+* every tree that adds members overrides this.
+*/
+template<typename Key, typename Value>
+size_t BinarySearchTree<Key, Value>::treeBytes() const
+{
+    return sizeof(BinarySearchTree<Key, Value>);
+}
+
 template<typename Key, typename Value>
 int BinarySearchTree<Key, Value>::checkBalance(Node<Key, Value>* node) const { 
   if (node == nullptr){
@@ -814,6 +1359,25 @@ void BinarySearchTree<Key, Value>::nodeSwap( Node<Key,Value>* n1, Node<Key,Value
         this->root_ = n1;
     }
 
+    //the cached extremes follow the position, not the node
+    if(leftmost_ == n1) leftmost_ = n2;
+    else if(leftmost_ == n2) leftmost_ = n1;
+    if(rightmost_ == n1) rightmost_ = n2;
+    else if(rightmost_ == n2) rightmost_ = n1;
+
+}
+
+/**
+ * Returns true if every leaf of the tree rooted at root is at the same
+ * depth. The same iterative, early-exit walk as equalPaths in
+ * equal-paths.cpp, but for the Node<Key, Value> trees in this file.
+ */
+template<typename Key, typename Value>
+bool equalPaths(Node<Key, Value>* root)
+{
+    return equalPathsGeneric(root,
+        [](Node<Key, Value>* n) { return n->getLeft(); },
+        [](Node<Key, Value>* n) { return n->getRight(); });
 }
 
 /**
@@ -822,14 +1386,18 @@ void BinarySearchTree<Key, Value>::nodeSwap( Node<Key,Value>* n1, Node<Key,Value
    Just call it with a node to start printing at, e.g:
    this->printRoot(this->root_) // or any other node pointer
 
-   It will print up to 5 levels of the tree rooted at the passed node,
-   in ASCII graphics format.
+   It will print up to 6 levels of the tree rooted at the passed node,
+   in ASCII graphics format. print(height) and printAround(key, height)
+   print fewer levels, or the part of the tree around one key.
    We hope it will make debugging easier!
   */
 
 // include print function (in its own file because it's fairly long)
 #include "print_bst.h"
 
+// parallel_for_each / parallel_reduce over a tree's items
+#include "tree-parallel.h"
+
 /*
 ---------------------------------------------------
 End implementations for the BinarySearchTree class.
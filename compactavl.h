@@ -0,0 +1,866 @@
+#ifndef COMPACTAVL_H
+#define COMPACTAVL_H
+
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include <utility>
+
+/**
+* A node for CompactAVLTree. Unlike AVLNode there is no parent pointer and
+* no vtable, and the balance factor lives in the two low bits of the left
+* child pointer, so a node is just the item plus two words.
+*/
+template <typename Key, typename Value>
+class CompactAVLNode
+{
+public:
+    CompactAVLNode(const Key& key, const Value& value);
+
+    const std::pair<const Key, Value>& getItem() const;
+    std::pair<const Key, Value>& getItem();
+    const Key& getKey() const;
+    const Value& getValue() const;
+    Value& getValue();
+    void setValue(const Value &value);
+
+    CompactAVLNode<Key, Value>* getLeft() const;
+    CompactAVLNode<Key, Value>* getRight() const;
+    CompactAVLNode<Key, Value>* getChild(int dir) const;
+    void setLeft(CompactAVLNode<Key, Value>* left);
+    void setRight(CompactAVLNode<Key, Value>* right);
+    void setChild(int dir, CompactAVLNode<Key, Value>* child);
+
+    // Same convention as AVLNode: height(right) - height(left), but only
+    // -1, 0 and 1 can be stored.
+    int8_t getBalance() const;
+    void setBalance(int8_t balance);
+
+protected:
+    // balance + 1 (0, 1 or 2) is stored in these bits of left_
+    static const uintptr_t BALANCE_MASK = 3;
+
+    std::pair<const Key, Value> item_;
+    uintptr_t left_;
+    CompactAVLNode<Key, Value>* right_;
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the CompactAVLNode class.
+  -------------------------------------------------
+*/
+
+template<class Key, class Value>
+CompactAVLNode<Key, Value>::CompactAVLNode(const Key& key, const Value& value) :
+    item_(key, value), left_(1), right_(nullptr)
+{
+  //left_ == 1 is a null left child with balance 0
+}
+
+template<class Key, class Value>
+const std::pair<const Key, Value>& CompactAVLNode<Key, Value>::getItem() const
+{
+    return item_;
+}
+
+template<class Key, class Value>
+std::pair<const Key, Value>& CompactAVLNode<Key, Value>::getItem()
+{
+    return item_;
+}
+
+template<class Key, class Value>
+const Key& CompactAVLNode<Key, Value>::getKey() const
+{
+    return item_.first;
+}
+
+template<class Key, class Value>
+const Value& CompactAVLNode<Key, Value>::getValue() const
+{
+    return item_.second;
+}
+
+template<class Key, class Value>
+Value& CompactAVLNode<Key, Value>::getValue()
+{
+    return item_.second;
+}
+
+template<class Key, class Value>
+void CompactAVLNode<Key, Value>::setValue(const Value& value)
+{
+    item_.second = value;
+}
+
+/**
+* Masks the balance bits off the left link.
+*/
+template<class Key, class Value>
+CompactAVLNode<Key, Value>* CompactAVLNode<Key, Value>::getLeft() const
+{
+    return reinterpret_cast<CompactAVLNode<Key, Value>*>(left_ & ~BALANCE_MASK);
+}
+
+template<class Key, class Value>
+CompactAVLNode<Key, Value>* CompactAVLNode<Key, Value>::getRight() const
+{
+    return right_;
+}
+
+/**
+* dir is 0 for the left child and 1 for the right child.
+*/
+template<class Key, class Value>
+CompactAVLNode<Key, Value>* CompactAVLNode<Key, Value>::getChild(int dir) const
+{
+    return dir == 0 ? getLeft() : getRight();
+}
+
+/**
+* Sets the left child while keeping the balance bits.
+*/
+template<class Key, class Value>
+void CompactAVLNode<Key, Value>::setLeft(CompactAVLNode<Key, Value>* left)
+{
+    left_ = reinterpret_cast<uintptr_t>(left) | (left_ & BALANCE_MASK);
+}
+
+template<class Key, class Value>
+void CompactAVLNode<Key, Value>::setRight(CompactAVLNode<Key, Value>* right)
+{
+    right_ = right;
+}
+
+template<class Key, class Value>
+void CompactAVLNode<Key, Value>::setChild(int dir, CompactAVLNode<Key, Value>* child)
+{
+    if (dir == 0){
+      setLeft(child);
+    }
+    else {
+      setRight(child);
+    }
+}
+
+template<class Key, class Value>
+int8_t CompactAVLNode<Key, Value>::getBalance() const
+{
+    return (int8_t)((int)(left_ & BALANCE_MASK) - 1);
+}
+
+template<class Key, class Value>
+void CompactAVLNode<Key, Value>::setBalance(int8_t balance)
+{
+    left_ = (left_ & ~BALANCE_MASK) | (uintptr_t)(balance + 1);
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the CompactAVLNode class.
+  -----------------------------------------------
+*/
+
+/**
+* The parent-free AVL algorithms behind CompactAVLTree and AVLSet. They only
+* use a node's key, links and two-bit balance (getKey, getLeft/getRight/
+* getChild, setLeft/setRight/setChild, getBalance/setBalance), so any node
+* type with CompactAVLNode's interface works. insert and remove record the
+* search path in a fixed-size stack and rebalance iteratively back up it.
+*/
+template <typename NodeT>
+struct CompactAVLAlgorithms
+{
+    // An AVL tree of height h holds at least fib(h+2)-1 nodes, so 96 levels
+    // is more than any 64-bit address space can hold.
+    static const int MAX_HEIGHT = 96;
+
+    template<typename Key, typename Make>
+    static NodeT* insert(NodeT*& root, const Key& key, Make make, bool& inserted);
+    template<typename Key>
+    static bool remove(NodeT*& root, const Key& key);
+    template<typename Key>
+    static NodeT* find(NodeT* root, const Key& key);
+    static void destroy(NodeT* node);
+    static int checkBalance(const NodeT* node);
+
+    static NodeT* rebalance(NodeT* node, int balance);
+    static NodeT* rotateLeft(NodeT* node, int balance);
+    static NodeT* rotateRight(NodeT* node, int balance);
+    static void relink(NodeT*& root, NodeT** path, int* dirs, int i, NodeT* n);
+};
+
+/**
+* The root-to-node path an iterator over a parent-free tree carries, since
+* its nodes cannot find their way back up. Empty is the end position.
+*/
+template <typename NodeT>
+struct CompactAVLPath
+{
+    CompactAVLPath();
+
+    NodeT* current() const;
+    void first(NodeT* root);
+    template<typename Key>
+    void seek(NodeT* root, const Key& key);
+    void next();
+
+    NodeT* path_[CompactAVLAlgorithms<NodeT>::MAX_HEIGHT];
+    int depth_;
+};
+
+/*
+  -----------------------------------------------------------
+  Begin implementations for CompactAVLAlgorithms and CompactAVLPath.
+  -----------------------------------------------------------
+*/
+
+template<typename NodeT>
+template<typename Key>
+NodeT* CompactAVLAlgorithms<NodeT>::find(NodeT* node, const Key& key)
+{
+    while (node != nullptr){
+      if (key < node->getKey()){
+        node = node->getLeft();
+      }
+      else if (node->getKey() < key){
+        node = node->getRight();
+      }
+      else {
+        return node;
+      }
+    }
+    return nullptr;
+}
+
+/**
+* Single rotations. The pivot's balance is passed in because a transient
+* +-2 does not fit in the two tag bits. Balances are updated with the
+* general formulas, which also cover the 0 child balance that only
+* happens on removal.
+*/
+template<typename NodeT>
+NodeT* CompactAVLAlgorithms<NodeT>::rotateLeft(NodeT* node, int balance)
+{
+    NodeT* rchild = node->getRight();
+    node->setRight(rchild->getLeft());
+    rchild->setLeft(node);
+
+    int nb = balance - 1 - std::max((int)rchild->getBalance(), 0);
+    int rb = rchild->getBalance() - 1 + std::min(nb, 0);
+    node->setBalance((int8_t)nb);
+    rchild->setBalance((int8_t)rb);
+    return rchild;
+}
+
+template<typename NodeT>
+NodeT* CompactAVLAlgorithms<NodeT>::rotateRight(NodeT* node, int balance)
+{
+    NodeT* lchild = node->getLeft();
+    node->setLeft(lchild->getRight());
+    lchild->setRight(node);
+
+    int nb = balance + 1 - std::min((int)lchild->getBalance(), 0);
+    int lb = lchild->getBalance() + 1 + std::max(nb, 0);
+    node->setBalance((int8_t)nb);
+    lchild->setBalance((int8_t)lb);
+    return lchild;
+}
+
+/**
+* Fixes a node whose (unstored) balance is +-2 with a single or double rotation and
+* returns the new root of its subtree.
+*/
+template<typename NodeT>
+NodeT* CompactAVLAlgorithms<NodeT>::rebalance(NodeT* node, int balance)
+{
+    if (balance == 2){
+      NodeT* rchild = node->getRight();
+      if (rchild->getBalance() >= 0){ //zigzig
+        return rotateLeft(node, balance);
+      }
+      //zigzag, done in one step since composing two single rotations
+      //would pass through a -2 on rchild, which cannot be stored
+      NodeT* gchild = rchild->getLeft();
+      node->setRight(gchild->getLeft());
+      rchild->setLeft(gchild->getRight());
+      gchild->setLeft(node);
+      gchild->setRight(rchild);
+      node->setBalance(gchild->getBalance() == 1 ? -1 : 0);
+      rchild->setBalance(gchild->getBalance() == -1 ? 1 : 0);
+      gchild->setBalance(0);
+      return gchild;
+    }
+    NodeT* lchild = node->getLeft();
+    if (lchild->getBalance() <= 0){ //zigzig
+      return rotateRight(node, balance);
+    }
+    NodeT* gchild = lchild->getRight();
+    lchild->setRight(gchild->getLeft());
+    node->setLeft(gchild->getRight());
+    gchild->setLeft(lchild);
+    gchild->setRight(node);
+    lchild->setBalance(gchild->getBalance() == 1 ? -1 : 0);
+    node->setBalance(gchild->getBalance() == -1 ? 1 : 0);
+    gchild->setBalance(0);
+    return gchild;
+}
+
+/**
+* Points whatever held path[i] (its parent on the path, or root) at n.
+*/
+template<typename NodeT>
+void CompactAVLAlgorithms<NodeT>::relink(NodeT*& root, NodeT** path, int* dirs, int i, NodeT* n)
+{
+    if (i == 0){
+      root = n;
+    }
+    else {
+      path[i - 1]->setChild(dirs[i - 1], n);
+    }
+}
+
+/**
+* Returns the node holding key. If there is none, make() builds one, it is
+* linked in, the tree is rebalanced and inserted is set.
+*/
+template<typename NodeT>
+template<typename Key, typename Make>
+NodeT* CompactAVLAlgorithms<NodeT>::insert(NodeT*& root, const Key& key, Make make, bool& inserted)
+{
+    /*
+    - walk down recording each node and the direction taken
+    - hang the new leaf off the last node on the path
+    - walk back up the path updating balances:
+        0 means the subtree height did not change, stop
+        +-1 means it grew by one, keep going
+        +-2 means rotate, after which the height is back to before, stop
+    */
+    NodeT* path[MAX_HEIGHT];
+    int dirs[MAX_HEIGHT];
+    int depth = 0;
+
+    inserted = false;
+    NodeT* node = root;
+    while (node != nullptr){
+      int dir;
+      if (key < node->getKey()){
+        dir = 0;
+      }
+      else if (node->getKey() < key){
+        dir = 1;
+      }
+      else {
+        return node;
+      }
+      path[depth] = node;
+      dirs[depth] = dir;
+      depth++;
+      node = node->getChild(dir);
+    }
+
+    NodeT* leaf = make();
+    inserted = true;
+    if (depth == 0){
+      root = leaf;
+      return leaf;
+    }
+    path[depth - 1]->setChild(dirs[depth - 1], leaf);
+
+    for (int i = depth - 1; i >= 0; i--){
+      node = path[i];
+      int balance = node->getBalance() + (dirs[i] == 0 ? -1 : 1);
+      if (balance == 2 || balance == -2){
+        relink(root, path, dirs, i, rebalance(node, balance));
+        break;
+      }
+      node->setBalance((int8_t)balance);
+      if (balance == 0){
+        break;
+      }
+    }
+    return leaf;
+}
+
+/**
+* Removes the key if present and says whether it was. A node with 2
+* children is replaced by its predecessor, as in the other trees.
+*/
+template<typename NodeT>
+template<typename Key>
+bool CompactAVLAlgorithms<NodeT>::remove(NodeT*& root, const Key& key)
+{
+    /*
+    - walk down recording the path; if the node has 2 children keep
+      walking to its predecessor (rightmost node of the left subtree)
+    - unlink the predecessor (it has no right child) and put it in the
+      removed node's place, so the recorded path stays valid
+    - walk back up updating balances:
+        +-1 means the subtree height did not change, stop
+        0 means it shrank by one, keep going
+        +-2 means rotate; if the new subtree root is balanced the height
+        still shrank, so keep going, otherwise stop
+    */
+    NodeT* path[MAX_HEIGHT];
+    int dirs[MAX_HEIGHT];
+    int depth = 0;
+
+    NodeT* node = root;
+    while (node != nullptr){
+      int dir;
+      if (key < node->getKey()){
+        dir = 0;
+      }
+      else if (node->getKey() < key){
+        dir = 1;
+      }
+      else {
+        break;
+      }
+      path[depth] = node;
+      dirs[depth] = dir;
+      depth++;
+      node = node->getChild(dir);
+    }
+    if (node == nullptr){
+      //nothing to remove
+      return false;
+    }
+
+    if (node->getLeft() != nullptr && node->getRight() != nullptr){
+      int target = depth;
+      path[depth] = node;
+      dirs[depth] = 0;
+      depth++;
+      NodeT* pred = node->getLeft();
+      while (pred->getRight() != nullptr){
+        path[depth] = pred;
+        dirs[depth] = 1;
+        depth++;
+        pred = pred->getRight();
+      }
+      //unlink pred, then let it take over node's links and balance
+      path[depth - 1]->setChild(dirs[depth - 1], pred->getLeft());
+      pred->setLeft(node->getLeft());
+      pred->setRight(node->getRight());
+      pred->setBalance(node->getBalance());
+      relink(root, path, dirs, target, pred);
+      path[target] = pred;
+    }
+    else {
+      NodeT* child = node->getLeft() != nullptr ? node->getLeft() : node->getRight();
+      relink(root, path, dirs, depth, child);
+    }
+    delete node;
+
+    for (int i = depth - 1; i >= 0; i--){
+      node = path[i];
+      int balance = node->getBalance() + (dirs[i] == 0 ? 1 : -1);
+      if (balance == 2 || balance == -2){
+        node = rebalance(node, balance);
+        relink(root, path, dirs, i, node);
+        if (node->getBalance() != 0){
+          break;
+        }
+        continue;
+      }
+      node->setBalance((int8_t)balance);
+      if (balance != 0){
+        break;
+      }
+    }
+    return true;
+}
+
+template<typename NodeT>
+void CompactAVLAlgorithms<NodeT>::destroy(NodeT* node)
+{
+    //recursion depth is bounded by the (logarithmic) height
+    if (node == nullptr){
+      return;
+    }
+    destroy(node->getLeft());
+    destroy(node->getRight());
+    delete node;
+}
+
+/**
+* The height of node's subtree, or -1 if it is unbalanced anywhere or a
+* stored balance factor does not match the actual subtree heights.
+*/
+template<typename NodeT>
+int CompactAVLAlgorithms<NodeT>::checkBalance(const NodeT* node)
+{
+    if (node == nullptr){
+      return 0;
+    }
+    int leftHeight = checkBalance(node->getLeft());
+    int rightHeight = checkBalance(node->getRight());
+    if (leftHeight == -1 || rightHeight == -1){
+      return -1;
+    }
+    if (std::abs(rightHeight - leftHeight) > 1 || rightHeight - leftHeight != node->getBalance()){
+      return -1;
+    }
+    return std::max(leftHeight, rightHeight) + 1;
+}
+
+template<typename NodeT>
+CompactAVLPath<NodeT>::CompactAVLPath() : depth_(0)
+{
+
+}
+
+template<typename NodeT>
+NodeT* CompactAVLPath<NodeT>::current() const
+{
+    return depth_ == 0 ? nullptr : path_[depth_ - 1];
+}
+
+/**
+* Positions the path on the smallest key under root.
+*/
+template<typename NodeT>
+void CompactAVLPath<NodeT>::first(NodeT* root)
+{
+    depth_ = 0;
+    for (NodeT* node = root; node != nullptr; node = node->getLeft()){
+      path_[depth_++] = node;
+    }
+}
+
+/**
+* Positions the path on key, filling it in on the way down, or at the end
+* if key is not there.
+*/
+template<typename NodeT>
+template<typename Key>
+void CompactAVLPath<NodeT>::seek(NodeT* root, const Key& key)
+{
+    depth_ = 0;
+    NodeT* node = root;
+    while (node != nullptr){
+      path_[depth_++] = node;
+      if (key < node->getKey()){
+        node = node->getLeft();
+      }
+      else if (node->getKey() < key){
+        node = node->getRight();
+      }
+      else {
+        return;
+      }
+    }
+    depth_ = 0;
+}
+
+/**
+* Advances in order. With a right subtree, descend to its leftmost node;
+* otherwise pop ancestors until we come up out of a left subtree.
+*/
+template<typename NodeT>
+void CompactAVLPath<NodeT>::next()
+{
+    if (depth_ == 0){
+      return;
+    }
+    NodeT* node = path_[depth_ - 1];
+    if (node->getRight() != nullptr){
+      node = node->getRight();
+      path_[depth_++] = node;
+      while (node->getLeft() != nullptr){
+        node = node->getLeft();
+        path_[depth_++] = node;
+      }
+    }
+    else {
+      --depth_;
+      while (depth_ > 0 && path_[depth_ - 1]->getRight() == node){
+        node = path_[--depth_];
+      }
+    }
+}
+
+/*
+  ---------------------------------------------------------
+  End implementations for CompactAVLAlgorithms and CompactAVLPath.
+  ---------------------------------------------------------
+*/
+
+/**
+* An AVL tree for memory-bound indices. Nodes have no parent pointers, so
+* insert and remove record the search path in a fixed-size stack and
+* rebalance iteratively back up that path (see CompactAVLAlgorithms), and
+* iterators carry their own ancestor stack. It offers the same
+* insert/remove/find/operator[]/iterator surface as BinarySearchTree, but
+* is not derived from it since every BinarySearchTree algorithm depends on
+* Node::getParent().
+*/
+template <class Key, class Value>
+class CompactAVLTree
+{
+public:
+    static const int MAX_HEIGHT = CompactAVLAlgorithms<CompactAVLNode<Key, Value> >::MAX_HEIGHT;
+
+    CompactAVLTree();
+    CompactAVLTree(CompactAVLTree&& other) noexcept;
+    CompactAVLTree& operator=(CompactAVLTree&& other) noexcept;
+    ~CompactAVLTree();
+    void swap(CompactAVLTree& other) noexcept;
+    void insert(const std::pair<const Key, Value>& keyValuePair);
+    void remove(const Key& key);
+    void clear();
+    bool isBalanced() const;
+    bool empty() const;
+
+    /**
+    * An iterator that keeps the path from the root to the current node.
+    */
+    class iterator
+    {
+    public:
+        iterator();
+
+        std::pair<const Key,Value>& operator*() const;
+        std::pair<const Key,Value>* operator->() const;
+
+        bool operator==(const iterator& rhs) const;
+        bool operator!=(const iterator& rhs) const;
+
+        iterator& operator++();
+
+    protected:
+        friend class CompactAVLTree<Key, Value>;
+
+        CompactAVLPath<CompactAVLNode<Key, Value> > path_;
+    };
+
+    iterator begin() const;
+    iterator end() const;
+    iterator find(const Key& key) const;
+    Value& operator[](const Key& key);
+    Value const & operator[](const Key& key) const;
+
+protected:
+    typedef CompactAVLAlgorithms<CompactAVLNode<Key, Value> > Algorithms;
+
+    CompactAVLNode<Key, Value>* internalFind(const Key& key) const;
+
+protected:
+    CompactAVLNode<Key, Value>* root_;
+
+private:
+    // nodes are owned, and copying would share them
+    CompactAVLTree(const CompactAVLTree&);
+    CompactAVLTree& operator=(const CompactAVLTree&);
+};
+
+/*
+--------------------------------------------------------------
+Begin implementations for the CompactAVLTree::iterator class.
+---------------------------------------------------------------
+*/
+
+template<class Key, class Value>
+CompactAVLTree<Key, Value>::iterator::iterator()
+{
+
+}
+
+template<class Key, class Value>
+std::pair<const Key,Value> &
+CompactAVLTree<Key, Value>::iterator::operator*() const
+{
+    return path_.current()->getItem();
+}
+
+template<class Key, class Value>
+std::pair<const Key,Value> *
+CompactAVLTree<Key, Value>::iterator::operator->() const
+{
+    return &(path_.current()->getItem());
+}
+
+template<class Key, class Value>
+bool CompactAVLTree<Key, Value>::iterator::operator==(const iterator& rhs) const
+{
+    return path_.current() == rhs.path_.current();
+}
+
+template<class Key, class Value>
+bool CompactAVLTree<Key, Value>::iterator::operator!=(const iterator& rhs) const
+{
+    return path_.current() != rhs.path_.current();
+}
+
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::iterator&
+CompactAVLTree<Key, Value>::iterator::operator++()
+{
+    path_.next();
+    return *this;
+}
+
+/*
+-------------------------------------------------------------
+End implementations for the CompactAVLTree::iterator class.
+-------------------------------------------------------------
+*/
+
+/*
+-----------------------------------------------------
+Begin implementations for the CompactAVLTree class.
+-----------------------------------------------------
+*/
+
+template<class Key, class Value>
+CompactAVLTree<Key, Value>::CompactAVLTree() :
+  root_(nullptr)
+{
+
+}
+
+/**
+* Takes over other's nodes in O(1), leaving other empty.
+*/
+template<class Key, class Value>
+CompactAVLTree<Key, Value>::CompactAVLTree(CompactAVLTree&& other) noexcept :
+  root_(other.root_)
+{
+    other.root_ = nullptr;
+}
+
+template<class Key, class Value>
+CompactAVLTree<Key, Value>& CompactAVLTree<Key, Value>::operator=(CompactAVLTree&& other) noexcept
+{
+    CompactAVLTree<Key, Value> old(std::move(other));
+    swap(old);
+    return *this;
+}
+
+template<class Key, class Value>
+CompactAVLTree<Key, Value>::~CompactAVLTree()
+{
+    clear();
+}
+
+template<class Key, class Value>
+void CompactAVLTree<Key, Value>::swap(CompactAVLTree& other) noexcept
+{
+    std::swap(root_, other.root_);
+}
+
+template<class Key, class Value>
+bool CompactAVLTree<Key, Value>::empty() const
+{
+    return root_ == nullptr;
+}
+
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::iterator
+CompactAVLTree<Key, Value>::begin() const
+{
+    iterator it;
+    it.path_.first(root_);
+    return it;
+}
+
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::iterator
+CompactAVLTree<Key, Value>::end() const
+{
+    return iterator();
+}
+
+/**
+* Returns an iterator to the item with the given key, or end(). The
+* iterator's path is filled in on the way down.
+*/
+template<class Key, class Value>
+typename CompactAVLTree<Key, Value>::iterator
+CompactAVLTree<Key, Value>::find(const Key& key) const
+{
+    iterator it;
+    it.path_.seek(root_, key);
+    return it;
+}
+
+/**
+ * @precondition The key exists in the map
+ * Returns the value associated with the key
+ */
+template<class Key, class Value>
+Value& CompactAVLTree<Key, Value>::operator[](const Key& key)
+{
+    CompactAVLNode<Key, Value>* curr = internalFind(key);
+    if(curr == nullptr) throw std::out_of_range("Invalid key");
+    return curr->getValue();
+}
+
+template<class Key, class Value>
+Value const & CompactAVLTree<Key, Value>::operator[](const Key& key) const
+{
+    CompactAVLNode<Key, Value>* curr = internalFind(key);
+    if(curr == nullptr) throw std::out_of_range("Invalid key");
+    return curr->getValue();
+}
+
+template<class Key, class Value>
+CompactAVLNode<Key, Value>* CompactAVLTree<Key, Value>::internalFind(const Key& key) const
+{
+    return Algorithms::find(root_, key);
+}
+
+/**
+* If key is already in the tree, the current value is overwritten
+* with the updated value.
+*/
+template<class Key, class Value>
+void CompactAVLTree<Key, Value>::insert(const std::pair<const Key, Value>& keyValuePair)
+{
+    bool inserted;
+    CompactAVLNode<Key, Value>* node = Algorithms::insert(root_, keyValuePair.first, [&keyValuePair]() {
+      return new CompactAVLNode<Key, Value>(keyValuePair.first, keyValuePair.second);
+    }, inserted);
+    if (!inserted){ //same key, so rewrite value
+      node->setValue(keyValuePair.second);
+    }
+}
+
+/**
+* Removes the key if present.
+*/
+template<class Key, class Value>
+void CompactAVLTree<Key, Value>::remove(const Key& key)
+{
+    Algorithms::remove(root_, key);
+}
+
+template<class Key, class Value>
+void CompactAVLTree<Key, Value>::clear()
+{
+    Algorithms::destroy(root_);
+    root_ = nullptr;
+}
+
+/**
+ * Return true iff the tree is balanced and every stored balance factor
+ * matches the actual subtree heights.
+ */
+template<class Key, class Value>
+bool CompactAVLTree<Key, Value>::isBalanced() const
+{
+    return Algorithms::checkBalance(root_) != -1;
+}
+
+/*
+---------------------------------------------------
+End implementations for the CompactAVLTree class.
+---------------------------------------------------
+*/
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef EQUAL_PATHS_GENERIC_H
+#define EQUAL_PATHS_GENERIC_H
+
+#include <vector>
+#include <utility>
+
+/**
+ * @brief Iterative leaf-depth check shared by the equalPaths overloads.
+ *
+ *        Walks the tree depth-first with an explicit stack (so deep or
+ *        skewed trees cannot overflow the call stack), remembers the depth
+ *        of the first leaf it reaches, and returns false as soon as a leaf
+ *        at another depth turns up, or an inner node sits at or below the
+ *        first leaf's depth (it must have a deeper leaf under it).
+ *
+ *        The node type is only reached through the left/right accessors,
+ *        so this works for equal-paths.h's Node as well as bst.h's
+ *        Node<Key, Value>.
+ *
+ * @param root  Root of the tree (may be null, which counts as equal)
+ * @param left  Callable returning a node's left child
+ * @param right Callable returning a node's right child
+ */
+template <typename NodePtr, typename LeftFn, typename RightFn>
+bool equalPathsGeneric(NodePtr root, LeftFn left, RightFn right)
+{
+    if (root == nullptr){
+      return true;
+    }
+
+    std::vector<std::pair<NodePtr, int> > stack;
+    stack.reserve(64);
+    stack.push_back(std::make_pair(root, 1));
+    int leafDepth = 0; //0 until the first leaf is seen
+
+    while (!stack.empty()){
+      NodePtr node = stack.back().first;
+      int depth = stack.back().second;
+      stack.pop_back();
+
+      NodePtr lchild = left(node);
+      NodePtr rchild = right(node);
+      if (lchild == nullptr && rchild == nullptr){ //leaf node
+        if (leafDepth == 0){
+          leafDepth = depth;
+        }
+        else if (depth != leafDepth){
+          return false;
+        }
+        continue;
+      }
+      if (leafDepth != 0 && depth >= leafDepth){
+        return false; //some leaf below this node is deeper than the first one
+      }
+
+      //push right first so the left subtree is explored first
+      if (rchild != nullptr){
+        stack.push_back(std::make_pair(rchild, depth + 1));
+      }
+      if (lchild != nullptr){
+        stack.push_back(std::make_pair(lchild, depth + 1));
+      }
+    }
+    return true;
+}
+
+#endif
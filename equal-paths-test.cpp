@@ -55,22 +55,69 @@ void test5(const char* msg)
   cout << msg << ": " <<   equalPaths(a) << endl;
 }
 
+// b is a leaf at depth 2, so the walk can stop at c, an inner node at
+// that depth, without looking at d
+void test6(const char* msg)
+{
+  setNode(a,1,b,c);
+  setNode(b,2,NULL,NULL);
+  setNode(c,3,d,NULL);
+  setNode(d,4,NULL,NULL);
+  cout << msg << ": " <<   equalPaths(a) << endl;
+}
+
+void test7(const char* msg)
+{
+  setNode(a,1,b,c);
+  setNode(b,2,d,NULL);
+  setNode(c,3,NULL,e);
+  setNode(d,4,NULL,NULL);
+  setNode(e,5,NULL,NULL);
+  cout << msg << ": " <<   equalPaths(a) << endl;
+}
+
+// a chain far too deep for a recursive walk, once with a single leaf and
+// once with a second leaf hanging off the root
+void test8(const char* msg)
+{
+  const int n = 1000000;
+  Node** chain = new Node*[n];
+  for (int i = n - 1; i >= 0; i--) {
+    chain[i] = new Node(i, NULL, i + 1 < n ? chain[i + 1] : NULL);
+  }
+  cout << msg << ": " <<   equalPaths(chain[0]);
+  setNode(f,6,NULL,NULL);
+  chain[0]->left = f;
+  cout << " " << equalPaths(chain[0]) << endl;
+  for (int i = 0; i < n; i++) {
+    delete chain[i];
+  }
+  delete [] chain;
+}
+
 int main()
 {
   a = new Node(1);
   b = new Node(2);
   c = new Node(3);
   d = new Node(4);
+  e = new Node(5);
+  f = new Node(6);
 
   test1("Test1");
   test2("Test2");
   test3("Test3");
   test4("Test4");
   test5("Test5");
+  test6("Test6");
+  test7("Test7");
+  test8("Test8");
  
   delete a;
   delete b;
   delete c;
   delete d;
+  delete e;
+  delete f;
 }
 
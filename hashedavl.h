@@ -0,0 +1,306 @@
+#ifndef HASHEDAVL_H
+#define HASHEDAVL_H
+
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "avlbst.h"
+
+/**
+* An AVLTree with an open-addressing hash index from keys to nodes, for
+* maps whose traffic is mostly exact-key lookups but that still need
+* ordered iteration and lowerBound. find, operator[], remove and
+* overwriting inserts go through the index in O(1) expected time instead of
+* an O(log n) descent; everything ordered is the plain AVLTree.
+*
+* The index holds node pointers, which stay valid for as long as the item
+* is in the tree: nodeSwap relinks nodes rather than moving items between
+* them, and rotations only relink. It is kept current through the same
+* hooks as the other derived trees: nodeLinked adds a node and
+* nodeUnlinking drops it, so hinted inserts, buildSorted and the pops are
+* covered too.
+*
+* The table uses linear probing with backward-shift deletion (so there are
+* no tombstones to clean up), stays at most half full, and stores each
+* key's mixed hash next to the node pointer so a probe only touches a node
+* when the hashes agree. Keys need Hash and an operator== that agrees
+* with operator<.
+*/
+template <class Key, class Value, class Hash = std::hash<Key> >
+class HashedAVLTree : public AVLTree<Key, Value>
+{
+public:
+    typedef typename AVLTree<Key, Value>::iterator iterator;
+
+    HashedAVLTree();
+    HashedAVLTree(HashedAVLTree&& other) noexcept;
+    HashedAVLTree& operator=(HashedAVLTree&& other) noexcept;
+    void swap(HashedAVLTree& other) noexcept;
+    HashedAVLTree clone() const;
+    virtual void insert(const std::pair<const Key, Value>& new_item);
+    using AVLTree<Key, Value>::insert;
+    virtual void remove(const Key& key);
+    virtual void clear();
+    iterator find(const Key& key) const;
+    bool contains(const Key& key) const;
+    Value& operator[](const Key& key);
+    Value const & operator[](const Key& key) const;
+
+protected:
+    struct Slot
+    {
+        uint64_t hash;
+        Node<Key, Value>* node;     // nullptr for an empty slot
+    };
+
+    virtual void nodeLinked(Node<Key, Value>* n);
+    virtual void nodeUnlinking(Node<Key, Value>* n);
+    virtual size_t treeBytes() const;
+
+    uint64_t hashOf(const Key& key) const;
+    Node<Key, Value>* lookup(const Key& key) const;
+    void indexInsert(Node<Key, Value>* n);
+    void indexErase(Node<Key, Value>* n);
+    void grow();
+
+    std::vector<Slot> table_;   // power-of-two size, or empty once moved from
+    size_t indexed_;
+    Hash hasher_;
+};
+
+template<class Key, class Value, class Hash>
+HashedAVLTree<Key, Value, Hash>::HashedAVLTree() :
+    table_(16), indexed_(0)
+{
+
+}
+
+/**
+* The index moves with the nodes, whose addresses do not change. other is
+* left empty with no table, which the first insert allocates.
+*/
+template<class Key, class Value, class Hash>
+HashedAVLTree<Key, Value, Hash>::HashedAVLTree(HashedAVLTree&& other) noexcept :
+    AVLTree<Key, Value>(static_cast<AVLTree<Key, Value>&&>(other)), table_(std::move(other.table_)),
+    indexed_(other.indexed_), hasher_(other.hasher_)
+{
+    other.table_.clear();
+    other.indexed_ = 0;
+}
+
+template<class Key, class Value, class Hash>
+HashedAVLTree<Key, Value, Hash>& HashedAVLTree<Key, Value, Hash>::operator=(HashedAVLTree&& other) noexcept
+{
+    HashedAVLTree<Key, Value, Hash> old(std::move(other));
+    swap(old);
+    return *this;
+}
+
+template<class Key, class Value, class Hash>
+void HashedAVLTree<Key, Value, Hash>::swap(HashedAVLTree& other) noexcept
+{
+    AVLTree<Key, Value>::swap(static_cast<AVLTree<Key, Value>&>(other));
+    table_.swap(other.table_);
+    std::swap(indexed_, other.indexed_);
+    std::swap(hasher_, other.hasher_);
+}
+
+/**
+* The copy's index is built as its nodes are linked.
+*/
+template<class Key, class Value, class Hash>
+HashedAVLTree<Key, Value, Hash> HashedAVLTree<Key, Value, Hash>::clone() const
+{
+    HashedAVLTree<Key, Value, Hash> copy;
+    copy.hasher_ = hasher_;
+    copy.cloneFrom(*this);
+    return copy;
+}
+
+/**
+* std::hash is the identity for integers, so the hash is multiplied by
+* 2^64 / phi and the well-mixed high half folded into the low bits, which
+* pick the slot.
+*/
+template<class Key, class Value, class Hash>
+uint64_t HashedAVLTree<Key, Value, Hash>::hashOf(const Key& key) const
+{
+    uint64_t h = (uint64_t)hasher_(key) * 0x9e3779b97f4a7c15ULL;
+    return h ^ (h >> 32);
+}
+
+template<class Key, class Value, class Hash>
+Node<Key, Value>* HashedAVLTree<Key, Value, Hash>::lookup(const Key& key) const
+{
+    if (table_.empty()){
+      return nullptr;
+    }
+    uint64_t h = hashOf(key);
+    size_t mask = table_.size() - 1;
+    for (size_t i = (size_t)h & mask; table_[i].node != nullptr; i = (i + 1) & mask){
+      if (table_[i].hash == h && table_[i].node->getKey() == key){
+        return table_[i].node;
+      }
+    }
+    return nullptr;
+}
+
+template<class Key, class Value, class Hash>
+void HashedAVLTree<Key, Value, Hash>::indexInsert(Node<Key, Value>* n)
+{
+    if (2 * (indexed_ + 1) > table_.size()){
+      grow();
+    }
+    uint64_t h = hashOf(n->getKey());
+    size_t mask = table_.size() - 1;
+    size_t i = (size_t)h & mask;
+    while (table_[i].node != nullptr){
+      i = (i + 1) & mask;
+    }
+    table_[i].hash = h;
+    table_[i].node = n;
+    indexed_++;
+}
+
+/**
+* Empties n's slot, then walks the rest of the cluster moving back every
+* entry whose home slot is at or before the hole, so that every probe
+* sequence stays unbroken.
+*/
+template<class Key, class Value, class Hash>
+void HashedAVLTree<Key, Value, Hash>::indexErase(Node<Key, Value>* n)
+{
+    size_t mask = table_.size() - 1;
+    size_t hole = (size_t)hashOf(n->getKey()) & mask;
+    while (table_[hole].node != n){
+      hole = (hole + 1) & mask;
+    }
+    for (size_t i = (hole + 1) & mask; table_[i].node != nullptr; i = (i + 1) & mask){
+      size_t home = (size_t)table_[i].hash & mask;
+      //distance from home to i versus from hole to i, around the ring
+      if (((i - home) & mask) >= ((i - hole) & mask)){
+        table_[hole] = table_[i];
+        hole = i;
+      }
+    }
+    table_[hole].node = nullptr;
+    indexed_--;
+}
+
+template<class Key, class Value, class Hash>
+void HashedAVLTree<Key, Value, Hash>::grow()
+{
+    std::vector<Slot> old(table_.empty() ? 16 : table_.size() * 2);
+    old.swap(table_);
+    size_t mask = table_.size() - 1;
+    for (size_t j = 0; j < old.size(); j++){
+      if (old[j].node != nullptr){
+        size_t i = (size_t)old[j].hash & mask;
+        while (table_[i].node != nullptr){
+          i = (i + 1) & mask;
+        }
+        table_[i] = old[j];
+      }
+    }
+}
+
+template<class Key, class Value, class Hash>
+void HashedAVLTree<Key, Value, Hash>::nodeLinked(Node<Key, Value>* n)
+{
+    AVLTree<Key, Value>::nodeLinked(n);
+    indexInsert(n);
+}
+
+template<class Key, class Value, class Hash>
+void HashedAVLTree<Key, Value, Hash>::nodeUnlinking(Node<Key, Value>* n)
+{
+    AVLTree<Key, Value>::nodeUnlinking(n);
+    indexErase(n);
+}
+
+/**
+* The index table lives outside the nodes, so it is counted here.
+*/
+template<class Key, class Value, class Hash>
+size_t HashedAVLTree<Key, Value, Hash>::treeBytes() const
+{
+    return sizeof(HashedAVLTree<Key, Value, Hash>) + table_.capacity() * sizeof(Slot);
+}
+
+/**
+* An existing key is overwritten in place without descending the tree.
+*/
+template<class Key, class Value, class Hash>
+void HashedAVLTree<Key, Value, Hash>::insert(const std::pair<const Key, Value>& new_item)
+{
+    Node<Key, Value>* node = lookup(new_item.first);
+    if (node != nullptr){
+      node->setValue(new_item.second);
+      this->nodeUpdated(node);
+      return;
+    }
+    AVLTree<Key, Value>::insert(new_item);
+}
+
+template<class Key, class Value, class Hash>
+void HashedAVLTree<Key, Value, Hash>::remove(const Key& key)
+{
+    //a key inserted earlier in a bulk load has to be indexed to go
+    this->applyBulk();
+    Node<Key, Value>* node = lookup(key);
+    if (node == nullptr){
+      //nothing to remove
+      return;
+    }
+    this->removeNode(node);
+}
+
+/**
+* Drops the index along with the nodes, back to its initial size.
+*/
+template<class Key, class Value, class Hash>
+void HashedAVLTree<Key, Value, Hash>::clear()
+{
+    AVLTree<Key, Value>::clear();
+    std::vector<Slot>(16).swap(table_);
+    indexed_ = 0;
+}
+
+template<class Key, class Value, class Hash>
+typename HashedAVLTree<Key, Value, Hash>::iterator
+HashedAVLTree<Key, Value, Hash>::find(const Key& key) const
+{
+    return this->makeIterator(lookup(key));
+}
+
+template<class Key, class Value, class Hash>
+bool HashedAVLTree<Key, Value, Hash>::contains(const Key& key) const
+{
+    return lookup(key) != nullptr;
+}
+
+/**
+ * @precondition The key exists in the map
+ * Returns the value associated with the key
+ */
+template<class Key, class Value, class Hash>
+Value& HashedAVLTree<Key, Value, Hash>::operator[](const Key& key)
+{
+    Node<Key, Value>* curr = lookup(key);
+    if(curr == nullptr) throw std::out_of_range("Invalid key");
+    return curr->getValue();
+}
+
+template<class Key, class Value, class Hash>
+Value const & HashedAVLTree<Key, Value, Hash>::operator[](const Key& key) const
+{
+    Node<Key, Value>* curr = lookup(key);
+    if(curr == nullptr) throw std::out_of_range("Invalid key");
+    return curr->getValue();
+}
+
+#endif
@@ -0,0 +1,343 @@
+#ifndef INTERNEDAVL_H
+#define INTERNEDAVL_H
+
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "avlbst.h"
+
+/**
+* A non-owning view of a byte string, ordered like std::string (bytes
+* compared as unsigned char, then shorter first). 16 bytes, against 32 for
+* a std::string, and never a separate allocation.
+*/
+struct StringRef
+{
+    StringRef() : data(""), length(0) {}
+    StringRef(const char* d, uint32_t l) : data(d), length(l) {}
+    StringRef(const std::string& s) : data(s.data()), length((uint32_t)s.size()) {}
+    StringRef(const char* s) : data(s), length((uint32_t)std::strlen(s)) {}
+
+    std::string str() const { return std::string(data, length); }
+    // <0, 0 or >0, like std::string::compare
+    static int compare(const StringRef& a, const StringRef& b);
+
+    const char* data;
+    uint32_t length;
+};
+
+inline int StringRef::compare(const StringRef& a, const StringRef& b)
+{
+    uint32_t common = a.length < b.length ? a.length : b.length;
+    int cmp = common == 0 ? 0 : std::memcmp(a.data, b.data, common);
+    if (cmp != 0){
+      return cmp;
+    }
+    return a.length < b.length ? -1 : (a.length > b.length ? 1 : 0);
+}
+
+inline bool operator<(const StringRef& a, const StringRef& b)
+{
+    return StringRef::compare(a, b) < 0;
+}
+
+inline bool operator>(const StringRef& a, const StringRef& b)
+{
+    return StringRef::compare(a, b) > 0;
+}
+
+inline bool operator==(const StringRef& a, const StringRef& b)
+{
+    return a.length == b.length && StringRef::compare(a, b) == 0;
+}
+
+inline std::ostream& operator<<(std::ostream& out, const StringRef& s)
+{
+    return out.write(s.data, s.length);
+}
+
+/**
+* A bump allocator for key bytes. Keys are packed back to back into 64 KiB
+* chunks that never move, so a StringRef into the arena stays valid until
+* clear(); keys too big to share a chunk get one of their own. Nothing is
+* freed individually.
+*/
+class KeyArena
+{
+public:
+    static const size_t CHUNK_BYTES = 1 << 16;
+
+    KeyArena();
+    KeyArena(KeyArena&& other) noexcept;
+    KeyArena& operator=(KeyArena&& other) noexcept;
+    ~KeyArena();
+    void swap(KeyArena& other) noexcept;
+
+    StringRef intern(const char* data, size_t length);
+    void clear();
+    // bytes held in chunks, used or not
+    size_t capacity() const;
+
+private:
+    KeyArena(const KeyArena&);
+    KeyArena& operator=(const KeyArena&);
+
+    std::vector<char*> chunks_;
+    char* cursor_;
+    size_t left_;       // free bytes at cursor_
+    size_t capacity_;
+};
+
+inline KeyArena::KeyArena() :
+    cursor_(nullptr), left_(0), capacity_(0)
+{
+
+}
+
+/**
+* Chunks never move, so views into other stay valid, now owned here.
+*/
+inline KeyArena::KeyArena(KeyArena&& other) noexcept :
+    chunks_(std::move(other.chunks_)), cursor_(other.cursor_),
+    left_(other.left_), capacity_(other.capacity_)
+{
+    other.chunks_.clear();
+    other.cursor_ = nullptr;
+    other.left_ = 0;
+    other.capacity_ = 0;
+}
+
+inline KeyArena& KeyArena::operator=(KeyArena&& other) noexcept
+{
+    KeyArena old(std::move(other));
+    swap(old);
+    return *this;
+}
+
+inline KeyArena::~KeyArena()
+{
+    clear();
+}
+
+inline void KeyArena::swap(KeyArena& other) noexcept
+{
+    chunks_.swap(other.chunks_);
+    std::swap(cursor_, other.cursor_);
+    std::swap(left_, other.left_);
+    std::swap(capacity_, other.capacity_);
+}
+
+/**
+* Copies the bytes into the arena and returns a view of the copy. Throws
+* std::length_error for keys of 4 GiB or more, which a StringRef cannot
+* describe.
+*/
+inline StringRef KeyArena::intern(const char* data, size_t length)
+{
+    if (length > UINT32_MAX){
+      throw std::length_error("Key too long");
+    }
+    if (length > CHUNK_BYTES / 4){
+      char* own = new char[length];
+      std::memcpy(own, data, length);
+      //cursor_ and left_ still point into the chunk being filled
+      chunks_.push_back(own);
+      capacity_ += length;
+      return StringRef(own, (uint32_t)length);
+    }
+    if (length > left_){
+      cursor_ = new char[CHUNK_BYTES];
+      chunks_.push_back(cursor_);
+      left_ = CHUNK_BYTES;
+      capacity_ += CHUNK_BYTES;
+    }
+    char* copy = cursor_;
+    if (length > 0){
+      std::memcpy(copy, data, length);
+    }
+    cursor_ += length;
+    left_ -= length;
+    return StringRef(copy, (uint32_t)length);
+}
+
+inline void KeyArena::clear()
+{
+    for (size_t i = 0; i < chunks_.size(); i++){
+      delete [] chunks_[i];
+    }
+    chunks_.clear();
+    cursor_ = nullptr;
+    left_ = 0;
+    capacity_ = 0;
+}
+
+inline size_t KeyArena::capacity() const
+{
+    return capacity_;
+}
+
+/**
+* An AVLTree with string keys whose bytes live in a tree-owned KeyArena
+* instead of one std::string (and often one heap block) per key. Nodes
+* hold a StringRef into the arena, so keys are allocated in bulk, sit
+* densely in memory in insertion order, and are all freed at once by
+* clear() or the destructor.
+*
+* Every insert copies a new key into the arena, whatever the StringRef
+* passed in points at, and lookups accept any StringRef or std::string.
+* Removing a key unlinks its node but leaves its bytes in the arena until
+* clear(), so the arena suits trees that mostly grow.
+*/
+template <class Value>
+class InternedAVLTree : public AVLTree<StringRef, Value>
+{
+public:
+    typedef typename AVLTree<StringRef, Value>::iterator iterator;
+
+    InternedAVLTree();
+    InternedAVLTree(InternedAVLTree&& other) noexcept;
+    InternedAVLTree& operator=(InternedAVLTree&& other) noexcept;
+    virtual void insert(const std::pair<const StringRef, Value>& new_item);
+    void insert(const std::string& key, const Value& value);
+    using AVLTree<StringRef, Value>::insert;
+    virtual void clear();
+    bool contains(const StringRef& key) const;
+    size_t arenaBytes() const;
+    void swap(InternedAVLTree& other) noexcept;
+    InternedAVLTree clone() const;
+
+protected:
+    virtual AVLNode<StringRef, Value>* createNode(const StringRef& key, const Value& value);
+    virtual size_t treeBytes() const;
+
+    KeyArena arena_;
+};
+
+template<class Value>
+InternedAVLTree<Value>::InternedAVLTree()
+{
+
+}
+
+/**
+* Trees move and swap along with the arena their keys live in.
+*/
+template<class Value>
+InternedAVLTree<Value>::InternedAVLTree(InternedAVLTree&& other) noexcept :
+    AVLTree<StringRef, Value>(static_cast<AVLTree<StringRef, Value>&&>(other)),
+    arena_(std::move(other.arena_))
+{
+
+}
+
+template<class Value>
+InternedAVLTree<Value>& InternedAVLTree<Value>::operator=(InternedAVLTree&& other) noexcept
+{
+    InternedAVLTree<Value> old(std::move(other));
+    swap(old);
+    return *this;
+}
+
+template<class Value>
+void InternedAVLTree<Value>::swap(InternedAVLTree& other) noexcept
+{
+    AVLTree<StringRef, Value>::swap(static_cast<AVLTree<StringRef, Value>&>(other));
+    arena_.swap(other.arena_);
+}
+
+/**
+* The copy interns its keys into an arena of its own, packed in the
+* order they are cloned.
+*/
+template<class Value>
+InternedAVLTree<Value> InternedAVLTree<Value>::clone() const
+{
+    InternedAVLTree<Value> copy;
+    copy.cloneFrom(*this);
+    return copy;
+}
+
+/**
+* Nodes are only created for keys that are not in the tree yet, so this
+* is where a key gets its arena copy.
+*/
+template<class Value>
+AVLNode<StringRef, Value>* InternedAVLTree<Value>::createNode(const StringRef& key, const Value& value)
+{
+    return AVLTree<StringRef, Value>::createNode(arena_.intern(key.data, key.length), value);
+}
+
+/**
+* Same as AVLTree::insert, except that the node (and so the arena copy of
+* the key) is only created once the key is known to be new; overwriting a
+* value leaves the arena alone.
+*/
+template<class Value>
+void InternedAVLTree<Value>::insert(const std::pair<const StringRef, Value>& new_item)
+{
+    Node<StringRef, Value>* prev = nullptr;
+    Node<StringRef, Value>* curr = this->root_;
+    while (curr != nullptr){
+      int cmp = StringRef::compare(new_item.first, curr->getKey());
+      if (cmp == 0){ //same key, so rewrite value
+        curr->setValue(new_item.second);
+        this->nodeUpdated(curr);
+        return;
+      }
+      prev = curr;
+      curr = cmp < 0 ? curr->getLeft() : curr->getRight();
+    }
+
+    AVLNode<StringRef, Value>* node = createNode(new_item.first, new_item.second);
+    if (prev == nullptr){
+      this->root_ = node;
+      this->nodeLinked(node);
+      this->finger_ = node;
+      return;
+    }
+    this->linkNode(static_cast<AVLNode<StringRef, Value>*>(prev), node);
+}
+
+template<class Value>
+void InternedAVLTree<Value>::insert(const std::string& key, const Value& value)
+{
+    insert(std::make_pair(StringRef(key), value));
+}
+
+template<class Value>
+void InternedAVLTree<Value>::clear()
+{
+    AVLTree<StringRef, Value>::clear();
+    arena_.clear();
+}
+
+template<class Value>
+bool InternedAVLTree<Value>::contains(const StringRef& key) const
+{
+    return this->internalFind(key) != nullptr;
+}
+
+/**
+* Bytes the arena holds for keys, including unused chunk space.
+*/
+template<class Value>
+size_t InternedAVLTree<Value>::arenaBytes() const
+{
+    return arena_.capacity();
+}
+
+/**
+* Counts the arena's chunks as well; the nodes only hold views into them.
+*/
+template<class Value>
+size_t InternedAVLTree<Value>::treeBytes() const
+{
+    return sizeof(InternedAVLTree<Value>) + arena_.capacity();
+}
+
+#endif
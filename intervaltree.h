@@ -0,0 +1,228 @@
+#ifndef INTERVALTREE_H
+#define INTERVALTREE_H
+
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+#include <vector>
+#include <utility>
+#include <limits>
+#include <algorithm>
+#include "augmentedavl.h"
+
+/**
+* A closed interval [start, end], ordered by start and then end. It is the
+* key type of IntervalTree, so it provides the comparisons the trees use
+* and prints as [start, end].
+*/
+template <typename T>
+struct Interval
+{
+    Interval(const T& s, const T& e) : start(s), end(e) {}
+
+    T start;
+    T end;
+};
+
+template <typename T>
+bool operator<(const Interval<T>& a, const Interval<T>& b)
+{
+    return a.start < b.start || (!(b.start < a.start) && a.end < b.end);
+}
+
+template <typename T>
+bool operator>(const Interval<T>& a, const Interval<T>& b)
+{
+    return b < a;
+}
+
+template <typename T>
+bool operator==(const Interval<T>& a, const Interval<T>& b)
+{
+    return !(a < b) && !(b < a);
+}
+
+template <typename T>
+std::ostream& operator<<(std::ostream& out, const Interval<T>& interval)
+{
+    return out << '[' << interval.start << ", " << interval.end << ']';
+}
+
+/**
+* Aggregates the largest end point in a subtree of Interval keys.
+*/
+template <typename T>
+struct MaxEndMonoid
+{
+    typedef T Type;
+    static T identity() { return std::numeric_limits<T>::lowest(); }
+    template <typename Item>
+    static T lift(const Item& item) { return item.first.end; }
+    static T combine(const T& a, const T& b) { return std::max(a, b); }
+};
+
+/**
+* A map from closed intervals [start, end] to values, ordered by start
+* (then end), that finds every interval overlapping a query interval or
+* containing a point. It is an AugmentedAVLTree keyed on Interval whose
+* aggregate is the subtree's largest end, so rotations, insert and remove
+* keep it current through the same hooks.
+*
+* A query walks the tree in order, skipping any subtree whose largest end
+* is before the query, and everything starting after it. Every subtree
+* that is entered either holds a match or lies on one of the two boundary
+* paths, so a query reporting k intervals visits O(log n + k log n) nodes
+* at worst and O(log n + k) when the matches are clustered, as they are
+* for short intervals.
+*
+* Intervals are assumed to have start <= end; the three-argument insert
+* checks this. Inserting the same [start, end] twice overwrites the value.
+*/
+template <class T, class Value>
+class IntervalTree : public AugmentedAVLTree<Interval<T>, Value, MaxEndMonoid<T> >
+{
+public:
+    typedef typename AVLTree<Interval<T>, Value>::iterator iterator;
+
+    IntervalTree();
+    IntervalTree(IntervalTree&& other) noexcept;
+    IntervalTree& operator=(IntervalTree&& other) noexcept;
+    void swap(IntervalTree& other) noexcept;
+
+    using AugmentedAVLTree<Interval<T>, Value, MaxEndMonoid<T> >::insert;
+    void insert(const T& start, const T& end, const Value& value);
+    std::vector<iterator> overlapping(const T& lo, const T& hi) const;
+    std::vector<iterator> stabbing(const T& point) const;
+    size_t countOverlapping(const T& lo, const T& hi) const;
+    IntervalTree clone() const;
+
+protected:
+    typedef AugmentedAVLTree<Interval<T>, Value, MaxEndMonoid<T> > Base;
+
+    template<typename Fn>
+    void visitOverlapping(const T& lo, const T& hi, Fn& fn) const;
+};
+
+template<class T, class Value>
+IntervalTree<T, Value>::IntervalTree()
+{
+
+}
+
+/**
+* The max-end aggregates live in the nodes, so they move with them.
+*/
+template<class T, class Value>
+IntervalTree<T, Value>::IntervalTree(IntervalTree&& other) noexcept :
+    Base(static_cast<Base&&>(other))
+{
+
+}
+
+template<class T, class Value>
+IntervalTree<T, Value>& IntervalTree<T, Value>::operator=(IntervalTree&& other) noexcept
+{
+    IntervalTree<T, Value> old(std::move(other));
+    swap(old);
+    return *this;
+}
+
+template<class T, class Value>
+void IntervalTree<T, Value>::swap(IntervalTree& other) noexcept
+{
+    Base::swap(static_cast<Base&>(other));
+}
+
+template<class T, class Value>
+IntervalTree<T, Value> IntervalTree<T, Value>::clone() const
+{
+    IntervalTree<T, Value> copy;
+    copy.cloneFrom(*this);
+    return copy;
+}
+
+/**
+* Throws std::invalid_argument if end < start.
+*/
+template<class T, class Value>
+void IntervalTree<T, Value>::insert(const T& start, const T& end, const Value& value)
+{
+    if (end < start){
+      throw std::invalid_argument("Invalid interval");
+    }
+    this->insert(std::make_pair(Interval<T>(start, end), value));
+}
+
+/**
+* Calls fn(node) for every interval overlapping [lo, hi], in order.
+*/
+template<class T, class Value>
+template<typename Fn>
+void IntervalTree<T, Value>::visitOverlapping(const T& lo, const T& hi, Fn& fn) const
+{
+    std::vector<Node<Interval<T>, Value>*> stack;
+    Node<Interval<T>, Value>* current = this->root_;
+    while (current != nullptr || !stack.empty()){
+      //push the left spine of current, minus what cannot overlap
+      while (current != nullptr && !(this->aggregateOf(current) < lo)){
+        if (hi < current->getKey().start){ //this node and its right subtree start too late
+          current = current->getLeft();
+        }
+        else {
+          stack.push_back(current);
+          current = current->getLeft();
+        }
+      }
+      if (stack.empty()){
+        return;
+      }
+      Node<Interval<T>, Value>* node = stack.back();
+      stack.pop_back();
+      if (!(node->getKey().end < lo)){
+        fn(node);
+      }
+      current = node->getRight();
+    }
+}
+
+/**
+* Every interval sharing at least one point with [lo, hi], in key order.
+*/
+template<class T, class Value>
+std::vector<typename IntervalTree<T, Value>::iterator>
+IntervalTree<T, Value>::overlapping(const T& lo, const T& hi) const
+{
+    std::vector<iterator> result;
+    auto collect = [&result](Node<Interval<T>, Value>* node) {
+      result.push_back(IntervalTree<T, Value>::makeIterator(node));
+    };
+    visitOverlapping(lo, hi, collect);
+    return result;
+}
+
+/**
+* Every interval containing point.
+*/
+template<class T, class Value>
+std::vector<typename IntervalTree<T, Value>::iterator>
+IntervalTree<T, Value>::stabbing(const T& point) const
+{
+    return overlapping(point, point);
+}
+
+/**
+* The number of intervals overlapping [lo, hi], without building a list.
+*/
+template<class T, class Value>
+size_t IntervalTree<T, Value>::countOverlapping(const T& lo, const T& hi) const
+{
+    size_t count = 0;
+    auto tally = [&count](Node<Interval<T>, Value>*) {
+      count++;
+    };
+    visitOverlapping(lo, hi, tally);
+    return count;
+}
+
+#endif
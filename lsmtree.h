@@ -0,0 +1,952 @@
+#ifndef LSMTREE_H
+#define LSMTREE_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "avlbst.h"
+
+/**
+* How LSMTree stores a key or value on disk. The default copies the bytes
+* of trivially copyable types (so run files are only portable between
+* machines of the same byte order); std::string is written as a 32-bit
+* length and its bytes. Other types need a specialization.
+*/
+template <typename T>
+struct LSMCodec
+{
+    static_assert(std::is_trivially_copyable<T>::value, "LSMCodec needs a specialization for this type");
+
+    static void write(std::ostream& out, const T& value)
+    {
+      out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    static bool read(std::istream& in, T& value)
+    {
+      return (bool)in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    }
+    static size_t size(const T&)
+    {
+      return sizeof(T);
+    }
+};
+
+template <>
+struct LSMCodec<std::string>
+{
+    static void write(std::ostream& out, const std::string& value)
+    {
+      uint32_t length = (uint32_t)value.size();
+      out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+      out.write(value.data(), length);
+    }
+    static bool read(std::istream& in, std::string& value)
+    {
+      uint32_t length;
+      if (!in.read(reinterpret_cast<char*>(&length), sizeof(length))){
+        return false;
+      }
+      value.resize(length);
+      return length == 0 || (bool)in.read(&value[0], length);
+    }
+    static size_t size(const std::string& value)
+    {
+      return sizeof(uint32_t) + value.size();
+    }
+};
+
+/**
+* memtableBytes: flush the memtable to a run once this many record bytes
+* have been written to it.
+* indexInterval: records per sparse index entry; a lookup in a run reads at
+* most this many records.
+* compactionTrigger: runs (at least 2) that start a compaction.
+* background: compact on a thread of the tree's own, or in the write that
+* made the run that reached the trigger.
+*/
+struct LSMOptions
+{
+    LSMOptions() :
+        memtableBytes(4 << 20), indexInterval(16), compactionTrigger(4), background(true)
+    {
+    }
+
+    size_t memtableBytes;
+    size_t indexInterval;
+    size_t compactionTrigger;
+    bool background;
+};
+
+/**
+* Byte counts are of encoded records. Write amplification is bytes written
+* to run files, by flushes and compactions, per byte inserted or removed.
+*/
+struct LSMStats
+{
+    LSMStats() :
+        userBytes(0), flushBytes(0), compactionBytes(0), flushes(0), compactions(0), runs(0)
+    {
+    }
+
+    double writeAmplification() const
+    {
+      return userBytes == 0 ? 0.0 : (double)(flushBytes + compactionBytes) / (double)userBytes;
+    }
+
+    uint64_t userBytes;
+    uint64_t flushBytes;
+    uint64_t compactionBytes;
+    size_t flushes;
+    size_t compactions;
+    size_t runs;
+};
+
+/**
+* An ordered key-value store on local disk, log-structured: writes go to
+* an AVLTree memtable, which is flushed by an in-order walk into an
+* immutable sorted run file once it is big enough, and runs are merged into
+* one by compaction (on a background thread by default) once there are
+* compactionTrigger of them. Removes write tombstones, which shadow older
+* values until a compaction drops them along with what they shadow. Memory
+* use is the memtable plus each run's sparse index, however much is stored.
+*
+* find checks the memtable and then the runs from newest to oldest; a run
+* is skipped unless the key is within its key range, and is otherwise
+* searched by a binary search of its sparse index and a read of at most
+* indexInterval records. scan merges the memtable and every run in key
+* order, newest version first.
+*
+* Files are named from a path prefix: prefix-manifest lists the live runs
+* and prefix-<id>.run holds each run. Opening an existing prefix reopens the
+* store as last flushed; the memtable is flushed when the tree is
+* destroyed, but writes since the last flush are lost in a crash, as there
+* is no write-ahead log. All operations may be called from several threads.
+* A flush runs in the write that fills the memtable, with other calls
+* waiting for it; compaction holds no lock while it merges.
+*
+* Key and Value need LSMCodec and a default constructor, and Key needs
+* operator<.
+*/
+template <class Key, class Value>
+class LSMTree
+{
+public:
+    explicit LSMTree(const std::string& prefix, const LSMOptions& options = LSMOptions());
+    ~LSMTree();
+
+    void insert(const std::pair<const Key, Value>& keyValuePair);
+    void remove(const Key& key);
+    bool find(const Key& key, Value& value) const;
+    bool contains(const Key& key) const;
+    // a copy, as the value may only exist on disk
+    Value operator[](const Key& key) const;
+    template<typename Fn>
+    void scan(const Key& lo, const Key& hi, Fn fn) const;
+
+    void flush();
+    void compact();
+    void clear();
+    LSMStats stats() const;
+
+protected:
+    struct Entry
+    {
+        Entry() : value(), tombstone(false) {}
+        Entry(const Value& v, bool t) : value(v), tombstone(t) {}
+
+        // for the memtable's print()
+        friend std::ostream& operator<<(std::ostream& out, const Entry& entry)
+        {
+          return entry.tombstone ? out << "(removed)" : out << entry.value;
+        }
+
+        Value value;
+        bool tombstone;
+    };
+
+    /**
+    * One run file, open for point lookups, with its sparse index in
+    * memory. A run that compaction has replaced is marked obsolete and its
+    * file deleted when the last reader lets go of it.
+    */
+    struct Run
+    {
+        explicit Run(const std::string& path);
+        ~Run();
+
+        bool lookup(const Key& key, Entry& entry);
+
+        std::string path;
+        std::ifstream in;
+        std::mutex readLock;
+        std::vector<Key> indexKeys;     // the first key of every block
+        std::vector<uint64_t> indexOffsets;
+        Key lastKey;
+        uint64_t records;
+        uint64_t interval;
+        std::atomic<bool> obsolete;
+    };
+    typedef std::shared_ptr<Run> RunPtr;
+
+    /**
+    * A sorted stream of entries, for merging.
+    */
+    class Source
+    {
+    public:
+        virtual ~Source() {}
+        virtual bool valid() const = 0;
+        virtual const Key& key() const = 0;
+        virtual const Entry& entry() const = 0;
+        virtual void next() = 0;
+    };
+
+    class MemorySource;
+    class RunSource;
+
+    class RunWriter
+    {
+    public:
+        RunWriter(const std::string& path, uint64_t interval);
+
+        void add(const Key& key, const Entry& entry);
+        // writes the index and trailer; returns the file's size
+        uint64_t finish();
+        uint64_t records() const;
+
+    protected:
+        std::string path_;
+        std::ofstream out_;
+        uint64_t interval_;
+        uint64_t offset_;
+        uint64_t records_;
+        std::vector<Key> indexKeys_;
+        std::vector<uint64_t> indexOffsets_;
+        Key lastKey_;
+    };
+
+    static const uint64_t RUN_MAGIC = 0x4c534d52554e3031ULL;  // "LSMRUN01"
+
+    static void writeEntry(std::ostream& out, const Key& key, const Entry& entry);
+    static bool readEntry(std::istream& in, Key& key, Entry& entry);
+    static uint64_t entryBytes(const Key& key, const Entry& entry);
+    template<typename Fn>
+    static void merge(const std::vector<Source*>& sources, const Key* hi, Fn fn);
+
+    void write(const Key& key, const Entry& entry);
+    void flushLocked();
+    bool compactOnce();
+    void compactionLoop();
+    std::string runPath(uint64_t id) const;
+    void readManifest();
+    void writeManifest() const;
+    void checkFailure() const;
+
+private:
+    // owns files and a thread
+    LSMTree(const LSMTree&);
+    LSMTree& operator=(const LSMTree&);
+
+protected:
+    std::string prefix_;
+    LSMOptions options_;
+    mutable std::mutex lock_;       // memtable, runs_, ids and stats
+    AVLTree<Key, Entry> memtable_;
+    uint64_t memtableBytes_;
+    std::vector<RunPtr> runs_;      // newest first
+    std::vector<uint64_t> runIds_;  // parallel to runs_
+    uint64_t nextId_;
+    LSMStats stats_;
+    std::mutex compactionLock_;     // one compaction at a time
+    std::condition_variable wake_;
+    bool stopping_;
+    std::exception_ptr failure_;    // what stopped background compaction
+    std::thread worker_;
+};
+
+/*
+--------------------------------------------------------------
+Begin implementations for the LSMTree helper classes.
+---------------------------------------------------------------
+*/
+
+/**
+* Opens a run and loads its index. The file ends with a fixed trailer:
+* index offset, index entries, records, interval and magic, all 64-bit;
+* the index (key and offset per entry) and the last key precede it.
+*/
+template<class Key, class Value>
+LSMTree<Key, Value>::Run::Run(const std::string& p) :
+    path(p), in(p.c_str(), std::ios::binary), records(0), interval(1), obsolete(false)
+{
+    uint64_t trailer[5];
+    if (!in || !in.seekg(-(std::streamoff)sizeof(trailer), std::ios::end)
+        || !in.read(reinterpret_cast<char*>(trailer), sizeof(trailer)) || trailer[4] != RUN_MAGIC){
+      throw std::runtime_error("Bad run file " + path);
+    }
+    records = trailer[2];
+    interval = trailer[3];
+    in.seekg((std::streamoff)trailer[0]);
+    indexKeys.resize((size_t)trailer[1]);
+    indexOffsets.resize((size_t)trailer[1]);
+    for (size_t i = 0; i < indexKeys.size(); i++){
+      if (!LSMCodec<Key>::read(in, indexKeys[i])
+          || !in.read(reinterpret_cast<char*>(&indexOffsets[i]), sizeof(uint64_t))){
+        throw std::runtime_error("Bad run file " + path);
+      }
+    }
+    if (records > 0 && !LSMCodec<Key>::read(in, lastKey)){
+      throw std::runtime_error("Bad run file " + path);
+    }
+}
+
+template<class Key, class Value>
+LSMTree<Key, Value>::Run::~Run()
+{
+    in.close();
+    if (obsolete){
+      std::remove(path.c_str());
+    }
+}
+
+/**
+* Binary searches the index for the block that would hold key and reads
+* through it.
+*/
+template<class Key, class Value>
+bool LSMTree<Key, Value>::Run::lookup(const Key& key, Entry& entry)
+{
+    if (records == 0 || key < indexKeys.front() || lastKey < key){
+      return false;
+    }
+    size_t block = std::upper_bound(indexKeys.begin(), indexKeys.end(), key) - indexKeys.begin() - 1;
+    uint64_t left = std::min(interval, records - block * interval);
+    std::lock_guard<std::mutex> guard(readLock);
+    in.clear();
+    in.seekg((std::streamoff)indexOffsets[block]);
+    Key current;
+    for (uint64_t i = 0; i < left; i++){
+      if (!readEntry(in, current, entry)){
+        throw std::runtime_error("Bad run file " + path);
+      }
+      if (!(current < key)){
+        return !(key < current);
+      }
+    }
+    return false;
+}
+
+/**
+* The memtable items of a scan, copied out under the lock.
+*/
+template<class Key, class Value>
+class LSMTree<Key, Value>::MemorySource : public LSMTree<Key, Value>::Source
+{
+public:
+    explicit MemorySource(const std::vector<std::pair<Key, Entry> >& items) : items_(items), pos_(0) {}
+
+    virtual bool valid() const { return pos_ < items_.size(); }
+    virtual const Key& key() const { return items_[pos_].first; }
+    virtual const Entry& entry() const { return items_[pos_].second; }
+    virtual void next() { pos_++; }
+
+protected:
+    const std::vector<std::pair<Key, Entry> >& items_;
+    size_t pos_;
+};
+
+/**
+* Reads a run sequentially through a stream of its own, starting from the
+* first key >= lo (or the start, for a null lo).
+*/
+template<class Key, class Value>
+class LSMTree<Key, Value>::RunSource : public LSMTree<Key, Value>::Source
+{
+public:
+    RunSource(const Run& run, const Key* lo) :
+        run_(run), in_(run.path.c_str(), std::ios::binary), left_(run.records), valid_(false)
+    {
+      if (run.records == 0){
+        return;
+      }
+      size_t block = 0;
+      if (lo != nullptr){
+        block = std::upper_bound(run.indexKeys.begin(), run.indexKeys.end(), *lo) - run.indexKeys.begin();
+        block = block == 0 ? 0 : block - 1;
+      }
+      in_.seekg((std::streamoff)run.indexOffsets[block]);
+      left_ = run.records - block * run.interval;
+      next();
+      while (valid_ && lo != nullptr && key_ < *lo){
+        next();
+      }
+    }
+
+    virtual bool valid() const { return valid_; }
+    virtual const Key& key() const { return key_; }
+    virtual const Entry& entry() const { return entry_; }
+    virtual void next()
+    {
+      valid_ = left_ > 0;
+      if (valid_){
+        if (!readEntry(in_, key_, entry_)){
+          throw std::runtime_error("Bad run file " + run_.path);
+        }
+        left_--;
+      }
+    }
+
+protected:
+    const Run& run_;
+    std::ifstream in_;
+    uint64_t left_;     // records not read yet
+    Key key_;
+    Entry entry_;
+    bool valid_;
+};
+
+template<class Key, class Value>
+LSMTree<Key, Value>::RunWriter::RunWriter(const std::string& path, uint64_t interval) :
+    path_(path), out_(path.c_str(), std::ios::binary | std::ios::trunc), interval_(interval),
+    offset_(0), records_(0)
+{
+    if (!out_){
+      throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+/**
+* Entries must come in increasing key order.
+*/
+template<class Key, class Value>
+void LSMTree<Key, Value>::RunWriter::add(const Key& key, const Entry& entry)
+{
+    if (records_ % interval_ == 0){
+      indexKeys_.push_back(key);
+      indexOffsets_.push_back(offset_);
+    }
+    writeEntry(out_, key, entry);
+    offset_ += entryBytes(key, entry);
+    records_++;
+    lastKey_ = key;
+}
+
+template<class Key, class Value>
+uint64_t LSMTree<Key, Value>::RunWriter::finish()
+{
+    uint64_t indexOffset = offset_;
+    for (size_t i = 0; i < indexKeys_.size(); i++){
+      LSMCodec<Key>::write(out_, indexKeys_[i]);
+      out_.write(reinterpret_cast<const char*>(&indexOffsets_[i]), sizeof(uint64_t));
+      offset_ += LSMCodec<Key>::size(indexKeys_[i]) + sizeof(uint64_t);
+    }
+    if (records_ > 0){
+      LSMCodec<Key>::write(out_, lastKey_);
+      offset_ += LSMCodec<Key>::size(lastKey_);
+    }
+    uint64_t trailer[5] = { indexOffset, indexKeys_.size(), records_, interval_, RUN_MAGIC };
+    out_.write(reinterpret_cast<const char*>(trailer), sizeof(trailer));
+    offset_ += sizeof(trailer);
+    out_.close();
+    if (!out_){
+      throw std::runtime_error("Cannot write " + path_);
+    }
+    return offset_;
+}
+
+template<class Key, class Value>
+uint64_t LSMTree<Key, Value>::RunWriter::records() const
+{
+    return records_;
+}
+
+/*
+-------------------------------------------------------------
+End implementations for the LSMTree helper classes.
+-------------------------------------------------------------
+*/
+
+/*
+-----------------------------------------------------
+Begin implementations for the LSMTree class.
+-----------------------------------------------------
+*/
+
+/**
+* Opens the store at prefix, creating it if there is no manifest yet. The
+* directory must exist.
+*/
+template<class Key, class Value>
+LSMTree<Key, Value>::LSMTree(const std::string& prefix, const LSMOptions& options) :
+    prefix_(prefix), options_(options), memtableBytes_(0), nextId_(1), stopping_(false)
+{
+    if (options_.indexInterval == 0){
+      options_.indexInterval = 1;
+    }
+    if (options_.compactionTrigger < 2){
+      options_.compactionTrigger = 2;
+    }
+    readManifest();
+    if (options_.background){
+      worker_ = std::thread(&LSMTree<Key, Value>::compactionLoop, this);
+    }
+}
+
+/**
+* Stops background compaction and flushes the memtable.
+*/
+template<class Key, class Value>
+LSMTree<Key, Value>::~LSMTree()
+{
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+      stopping_ = true;
+    }
+    wake_.notify_one();
+    if (worker_.joinable()){
+      worker_.join();
+    }
+    try {
+      std::lock_guard<std::mutex> guard(lock_);
+      flushLocked();
+    }
+    catch (const std::exception&){
+      //nowhere to report it from a destructor
+    }
+}
+
+template<class Key, class Value>
+void LSMTree<Key, Value>::writeEntry(std::ostream& out, const Key& key, const Entry& entry)
+{
+    char tombstone = entry.tombstone ? 1 : 0;
+    out.write(&tombstone, 1);
+    LSMCodec<Key>::write(out, key);
+    if (!entry.tombstone){
+      LSMCodec<Value>::write(out, entry.value);
+    }
+}
+
+template<class Key, class Value>
+bool LSMTree<Key, Value>::readEntry(std::istream& in, Key& key, Entry& entry)
+{
+    char tombstone;
+    if (!in.read(&tombstone, 1) || !LSMCodec<Key>::read(in, key)){
+      return false;
+    }
+    entry.tombstone = tombstone != 0;
+    return entry.tombstone || LSMCodec<Value>::read(in, entry.value);
+}
+
+template<class Key, class Value>
+uint64_t LSMTree<Key, Value>::entryBytes(const Key& key, const Entry& entry)
+{
+    return 1 + LSMCodec<Key>::size(key) + (entry.tombstone ? 0 : LSMCodec<Value>::size(entry.value));
+}
+
+/**
+* Calls fn(key, entry) for every distinct key of the sources, smallest
+* first, stopping at hi (exclusive, nullptr for none). Sources come newest
+* first, and of several entries for one key only the newest is passed on.
+*/
+template<class Key, class Value>
+template<typename Fn>
+void LSMTree<Key, Value>::merge(const std::vector<Source*>& sources, const Key* hi, Fn fn)
+{
+    while (true){
+      Source* best = nullptr;
+      for (size_t i = 0; i < sources.size(); i++){
+        //strictly smaller, so the newest source wins ties
+        if (sources[i]->valid() && (best == nullptr || sources[i]->key() < best->key())){
+          best = sources[i];
+        }
+      }
+      if (best == nullptr || (hi != nullptr && !(best->key() < *hi))){
+        return;
+      }
+      Key key = best->key();
+      fn(key, best->entry());
+      for (size_t i = 0; i < sources.size(); i++){
+        if (sources[i]->valid() && !(key < sources[i]->key())){
+          sources[i]->next();
+        }
+      }
+    }
+}
+
+template<class Key, class Value>
+std::string LSMTree<Key, Value>::runPath(uint64_t id) const
+{
+    std::ostringstream path;
+    path << prefix_ << "-" << id << ".run";
+    return path.str();
+}
+
+/**
+* The manifest is text: "next <id>", then "run <id>" per run, newest
+* first.
+*/
+template<class Key, class Value>
+void LSMTree<Key, Value>::readManifest()
+{
+    std::ifstream in((prefix_ + "-manifest").c_str());
+    if (!in){
+      return;
+    }
+    std::string word;
+    uint64_t id;
+    while (in >> word >> id){
+      if (word == "next"){
+        nextId_ = id;
+      }
+      else if (word == "run"){
+        runs_.push_back(RunPtr(new Run(runPath(id))));
+        runIds_.push_back(id);
+      }
+    }
+}
+
+/**
+* Writes the manifest to a temporary file and renames it over the old one,
+* so a crash leaves one or the other. Call with lock_ held.
+*/
+template<class Key, class Value>
+void LSMTree<Key, Value>::writeManifest() const
+{
+    std::string path = prefix_ + "-manifest";
+    std::string temp = path + ".tmp";
+    {
+      std::ofstream out(temp.c_str(), std::ios::trunc);
+      out << "next " << nextId_ << "\n";
+      for (size_t i = 0; i < runIds_.size(); i++){
+        out << "run " << runIds_[i] << "\n";
+      }
+      out.close();
+      if (!out){
+        throw std::runtime_error("Cannot write " + temp);
+      }
+    }
+    if (std::rename(temp.c_str(), path.c_str()) != 0){
+      throw std::runtime_error("Cannot replace " + path);
+    }
+}
+
+template<class Key, class Value>
+void LSMTree<Key, Value>::checkFailure() const
+{
+    if (failure_){
+      std::rethrow_exception(failure_);
+    }
+}
+
+/**
+* Puts entry in the memtable and flushes it if it is full. Compaction is
+* started (or, without a background thread, run) once the flush makes
+* enough runs.
+*/
+template<class Key, class Value>
+void LSMTree<Key, Value>::write(const Key& key, const Entry& entry)
+{
+    bool compactNow = false;
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+      checkFailure();
+      memtable_.insert(std::make_pair(key, entry));
+      uint64_t bytes = entryBytes(key, entry);
+      memtableBytes_ += bytes;
+      stats_.userBytes += bytes;
+      if (memtableBytes_ < options_.memtableBytes){
+        return;
+      }
+      flushLocked();
+      compactNow = runs_.size() >= options_.compactionTrigger;
+    }
+    if (compactNow){
+      if (options_.background){
+        wake_.notify_one();
+      }
+      else {
+        compactOnce();
+      }
+    }
+}
+
+/**
+* If key is already in the store, the current value is overwritten
+* with the updated value.
+*/
+template<class Key, class Value>
+void LSMTree<Key, Value>::insert(const std::pair<const Key, Value>& keyValuePair)
+{
+    write(keyValuePair.first, Entry(keyValuePair.second, false));
+}
+
+template<class Key, class Value>
+void LSMTree<Key, Value>::remove(const Key& key)
+{
+    write(key, Entry(Value(), true));
+}
+
+/**
+* Copies key's value into value and returns true, or returns false if key
+* is not in the store. Runs are read outside the lock.
+*/
+template<class Key, class Value>
+bool LSMTree<Key, Value>::find(const Key& key, Value& value) const
+{
+    std::vector<RunPtr> runs;
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+      typename AVLTree<Key, Entry>::iterator it = memtable_.find(key);
+      if (it != memtable_.end()){
+        if (it->second.tombstone){
+          return false;
+        }
+        value = it->second.value;
+        return true;
+      }
+      runs = runs_;
+    }
+    Entry entry;
+    for (size_t i = 0; i < runs.size(); i++){
+      if (runs[i]->lookup(key, entry)){
+        if (entry.tombstone){
+          return false;
+        }
+        value = entry.value;
+        return true;
+      }
+    }
+    return false;
+}
+
+template<class Key, class Value>
+bool LSMTree<Key, Value>::contains(const Key& key) const
+{
+    Value value;
+    return find(key, value);
+}
+
+/**
+ * @precondition The key exists in the store
+ * Returns the value associated with the key
+ */
+template<class Key, class Value>
+Value LSMTree<Key, Value>::operator[](const Key& key) const
+{
+    Value value;
+    if(!find(key, value)) throw std::out_of_range("Invalid key");
+    return value;
+}
+
+/**
+* Calls fn(key, value) for every item with a key in [lo, hi), in key
+* order. The memtable's part of the range is copied under the lock and the
+* runs are read outside it; writes made during the scan may or may not be
+* seen.
+*/
+template<class Key, class Value>
+template<typename Fn>
+void LSMTree<Key, Value>::scan(const Key& lo, const Key& hi, Fn fn) const
+{
+    std::vector<std::pair<Key, Entry> > items;
+    std::vector<RunPtr> runs;
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+      typename AVLTree<Key, Entry>::iterator it = memtable_.lowerBound(lo);
+      for (; it != memtable_.end() && it->first < hi; ++it){
+        items.push_back(*it);
+      }
+      runs = runs_;
+    }
+
+    MemorySource memory(items);
+    std::vector<std::unique_ptr<RunSource> > readers;
+    std::vector<Source*> sources(1, &memory);
+    for (size_t i = 0; i < runs.size(); i++){
+      readers.push_back(std::unique_ptr<RunSource>(new RunSource(*runs[i], &lo)));
+      sources.push_back(readers.back().get());
+    }
+    merge(sources, &hi, [&fn](const Key& key, const Entry& entry) {
+      if (!entry.tombstone){
+        fn(key, entry.value);
+      }
+    });
+}
+
+/**
+* Writes the memtable out as the newest run, in key order, and empties
+* it. Call with lock_ held.
+*/
+template<class Key, class Value>
+void LSMTree<Key, Value>::flushLocked()
+{
+    if (memtable_.empty()){
+      return;
+    }
+    uint64_t id = nextId_++;
+    RunWriter writer(runPath(id), options_.indexInterval);
+    for (typename AVLTree<Key, Entry>::iterator it = memtable_.begin(); it != memtable_.end(); ++it){
+      writer.add(it->first, it->second);
+    }
+    stats_.flushBytes += writer.finish();
+    stats_.flushes++;
+    runs_.insert(runs_.begin(), RunPtr(new Run(runPath(id))));
+    runIds_.insert(runIds_.begin(), id);
+    writeManifest();
+    memtable_.clear();
+    memtableBytes_ = 0;
+}
+
+template<class Key, class Value>
+void LSMTree<Key, Value>::flush()
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    checkFailure();
+    flushLocked();
+}
+
+/**
+* Merges every run there is when it starts into one, without holding lock_
+* while it reads and writes. Runs flushed meanwhile are newer than all the
+* inputs and stay in front of the result. The inputs include the oldest
+* run, so nothing older can be hiding under a tombstone, and tombstones are
+* dropped. Returns false if there were fewer than two runs.
+*/
+template<class Key, class Value>
+bool LSMTree<Key, Value>::compactOnce()
+{
+    std::lock_guard<std::mutex> only(compactionLock_);
+    std::vector<RunPtr> inputs;
+    uint64_t id;
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+      if (runs_.size() < 2){
+        return false;
+      }
+      inputs = runs_;
+      id = nextId_++;
+    }
+
+    std::vector<std::unique_ptr<RunSource> > readers;
+    std::vector<Source*> sources;
+    for (size_t i = 0; i < inputs.size(); i++){
+      readers.push_back(std::unique_ptr<RunSource>(new RunSource(*inputs[i], nullptr)));
+      sources.push_back(readers.back().get());
+    }
+    RunWriter writer(runPath(id), options_.indexInterval);
+    merge(sources, nullptr, [&writer](const Key& key, const Entry& entry) {
+      if (!entry.tombstone){
+        writer.add(key, entry);
+      }
+    });
+    uint64_t bytes = writer.finish();
+    readers.clear();
+    RunPtr merged;
+    if (writer.records() > 0){
+      merged = RunPtr(new Run(runPath(id)));
+    }
+    else {
+      std::remove(runPath(id).c_str());
+    }
+
+    std::lock_guard<std::mutex> guard(lock_);
+    size_t kept = runs_.size() - inputs.size();
+    runs_.resize(kept);
+    runIds_.resize(kept);
+    if (merged){
+      runs_.push_back(merged);
+      runIds_.push_back(id);
+    }
+    stats_.compactionBytes += bytes;
+    stats_.compactions++;
+    writeManifest();
+    for (size_t i = 0; i < inputs.size(); i++){
+      inputs[i]->obsolete = true;
+    }
+    return true;
+}
+
+template<class Key, class Value>
+void LSMTree<Key, Value>::compact()
+{
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+      checkFailure();
+    }
+    compactOnce();
+}
+
+template<class Key, class Value>
+void LSMTree<Key, Value>::compactionLoop()
+{
+    std::unique_lock<std::mutex> guard(lock_);
+    while (true){
+      wake_.wait(guard, [this]() {
+        return stopping_ || runs_.size() >= options_.compactionTrigger;
+      });
+      if (stopping_){
+        return;
+      }
+      guard.unlock();
+      try {
+        compactOnce();
+      }
+      catch (...){
+        guard.lock();
+        //surfaces in the next write, flush or compact
+        failure_ = std::current_exception();
+        return;
+      }
+      guard.lock();
+    }
+}
+
+/**
+* Empties the memtable and deletes every run.
+*/
+template<class Key, class Value>
+void LSMTree<Key, Value>::clear()
+{
+    std::lock_guard<std::mutex> only(compactionLock_);
+    std::lock_guard<std::mutex> guard(lock_);
+    memtable_.clear();
+    memtableBytes_ = 0;
+    for (size_t i = 0; i < runs_.size(); i++){
+      runs_[i]->obsolete = true;
+    }
+    runs_.clear();
+    runIds_.clear();
+    writeManifest();
+}
+
+template<class Key, class Value>
+LSMStats LSMTree<Key, Value>::stats() const
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    LSMStats current = stats_;
+    current.runs = runs_.size();
+    return current;
+}
+
+/*
+---------------------------------------------------
+End implementations for the LSMTree class.
+---------------------------------------------------
+*/
+
+#endif
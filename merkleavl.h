@@ -0,0 +1,278 @@
+#ifndef MERKLEAVL_H
+#define MERKLEAVL_H
+
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <algorithm>
+#include "augmentedavl.h"
+
+/**
+* The digest of a run of items in key order: a polynomial hash
+*   hash = h(item1) * B^(n-1) + h(item2) * B^(n-2) + ... + h(itemn)
+* modulo the prime 2^61 - 1, together with scale = B^n. Two adjacent runs
+* combine as a.hash * b.scale + b.hash, which is associative, so the digest
+* of a key range does not depend on how the tree that holds it is shaped.
+*/
+struct MerkleDigest
+{
+    uint64_t hash;
+    uint64_t scale;
+};
+
+inline bool operator==(const MerkleDigest& a, const MerkleDigest& b)
+{
+    return a.hash == b.hash && a.scale == b.scale;
+}
+
+inline bool operator!=(const MerkleDigest& a, const MerkleDigest& b)
+{
+    return !(a == b);
+}
+
+/**
+* Hashes (key, value) items with std::hash into MerkleDigests. The hashes
+* are not cryptographic: they catch accidental divergence between
+* replicas, not an adversary who picks keys to collide.
+*/
+template <typename Key, typename Value>
+struct MerkleMonoid
+{
+    typedef MerkleDigest Type;
+
+    static const uint64_t PRIME = (1ULL << 61) - 1;
+    static const uint64_t BASE = 0x1fb2c6a3d94e8057ULL % ((1ULL << 61) - 1);
+
+    static MerkleDigest identity()
+    {
+        MerkleDigest d = { 0, 1 };
+        return d;
+    }
+
+    template <typename Item>
+    static MerkleDigest lift(const Item& item)
+    {
+        uint64_t h = mix(std::hash<Key>()(item.first)) ^ mix(mix(std::hash<Value>()(item.second)) + 1);
+        MerkleDigest d = { reduce(h), BASE };
+        return d;
+    }
+
+    static MerkleDigest combine(const MerkleDigest& a, const MerkleDigest& b)
+    {
+        MerkleDigest d = { reduce(mulMod(a.hash, b.scale) + b.hash), mulMod(a.scale, b.scale) };
+        return d;
+    }
+
+    //splitmix64 finalizer: std::hash is the identity for integers
+    static uint64_t mix(uint64_t x)
+    {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    static uint64_t reduce(uint64_t x)
+    {
+        x = (x & PRIME) + (x >> 61);
+        return x >= PRIME ? x - PRIME : x;
+    }
+
+    // a * b mod 2^61 - 1, for a, b < 2^61
+    static uint64_t mulMod(uint64_t a, uint64_t b)
+    {
+#ifdef __SIZEOF_INT128__
+        unsigned __int128 product = (unsigned __int128)a * b;
+        return reduce((uint64_t)(product & PRIME) + (uint64_t)(product >> 61));
+#else
+        //split into 32-bit halves; 2^64 = 8 and 2^61 = 1 modulo the prime
+        uint64_t aHi = a >> 32, aLo = a & 0xffffffffULL;
+        uint64_t bHi = b >> 32, bLo = b & 0xffffffffULL;
+        uint64_t middle = aHi * bLo + aLo * bHi;    // < 2^62
+        uint64_t high = aHi * bHi;                  // < 2^58, weighs 2^64
+        uint64_t low = aLo * bLo;
+        uint64_t sum = reduce(low) + reduce(high << 3) + reduce((middle & 0x1fffffffULL) << 32) + (middle >> 29);
+        return reduce(sum);
+#endif
+    }
+};
+
+/**
+* An AVLTree whose nodes carry a Merkle-style digest of their subtree, for
+* comparing replicas cheaply. It is an AugmentedAVLTree over MerkleMonoid,
+* so insert, remove, update and every rotation keep the digests current in
+* O(log n) through the same hooks, and digest() is the root's in O(1).
+*
+* Unlike a classic Merkle tree the digests are shape-independent: two trees
+* holding the same items have the same digest whatever order they were
+* built in, and so does any key range of them. That is what lets diff()
+* compare two replicas whose AVL shapes have drifted apart, in
+* O(d log^2 n) for d differing keys.
+*
+* Key and Value need std::hash and operator==.
+*/
+template <class Key, class Value>
+class MerkleAVLTree : public AugmentedAVLTree<Key, Value, MerkleMonoid<Key, Value> >
+{
+public:
+    MerkleAVLTree();
+    MerkleAVLTree(MerkleAVLTree&& other) noexcept;
+    MerkleAVLTree& operator=(MerkleAVLTree&& other) noexcept;
+    void swap(MerkleAVLTree& other) noexcept;
+    uint64_t digest() const;
+    std::vector<Key> diff(const MerkleAVLTree<Key, Value>& other) const;
+    MerkleAVLTree clone() const;
+
+protected:
+    typedef AugmentedAVLTree<Key, Value, MerkleMonoid<Key, Value> > Base;
+
+    static void collectBetween(Node<Key, Value>* root, const Key* lo, const Key* hi, std::vector<Key>& keys);
+};
+
+template<class Key, class Value>
+MerkleAVLTree<Key, Value>::MerkleAVLTree()
+{
+
+}
+
+/**
+* Digests live in the nodes, so they move with them.
+*/
+template<class Key, class Value>
+MerkleAVLTree<Key, Value>::MerkleAVLTree(MerkleAVLTree&& other) noexcept :
+    Base(static_cast<Base&&>(other))
+{
+
+}
+
+template<class Key, class Value>
+MerkleAVLTree<Key, Value>& MerkleAVLTree<Key, Value>::operator=(MerkleAVLTree&& other) noexcept
+{
+    MerkleAVLTree<Key, Value> old(std::move(other));
+    swap(old);
+    return *this;
+}
+
+template<class Key, class Value>
+void MerkleAVLTree<Key, Value>::swap(MerkleAVLTree& other) noexcept
+{
+    Base::swap(static_cast<Base&>(other));
+}
+
+template<class Key, class Value>
+MerkleAVLTree<Key, Value> MerkleAVLTree<Key, Value>::clone() const
+{
+    MerkleAVLTree<Key, Value> copy;
+    copy.cloneFrom(*this);
+    return copy;
+}
+
+/**
+* The digest of every item in the tree, in O(1). Equal trees have equal
+* digests; unequal ones collide with probability about n / 2^61.
+*/
+template<class Key, class Value>
+uint64_t MerkleAVLTree<Key, Value>::digest() const
+{
+    return this->aggregate().hash;
+}
+
+/**
+* Appends the keys of root's subtree that lie strictly between lo and hi
+* (null for unbounded), in no particular order.
+*/
+template<class Key, class Value>
+void MerkleAVLTree<Key, Value>::collectBetween(Node<Key, Value>* root, const Key* lo, const Key* hi,
+                                               std::vector<Key>& keys)
+{
+    std::vector<Node<Key, Value>*> stack;
+    if (root != nullptr){
+      stack.push_back(root);
+    }
+    while (!stack.empty()){
+      Node<Key, Value>* n = stack.back();
+      stack.pop_back();
+      bool aboveLo = lo == nullptr || *lo < n->getKey();
+      bool belowHi = hi == nullptr || n->getKey() < *hi;
+      if (aboveLo && belowHi){
+        keys.push_back(n->getKey());
+      }
+      if (aboveLo && n->getLeft() != nullptr){
+        stack.push_back(n->getLeft());
+      }
+      if (belowHi && n->getRight() != nullptr){
+        stack.push_back(n->getRight());
+      }
+    }
+}
+
+/**
+* Every key that is in only one of the two trees, or maps to different
+* values in them, in increasing order, in O(d log^2 n) for d differences.
+*
+* Walks this tree from the root. A subtree of this tree covers the open key
+* range between its nearest ancestors on either side, and its cached digest
+* is compared with the other tree's digest of that same range; if they
+* match the subtree is skipped. Otherwise the subtree's own key is looked
+* up in the other tree and both children are checked the same way. An
+* empty child whose range is not empty in the other tree, or a subtree
+* whose range is empty there, is reported wholesale.
+*
+* Only subtrees containing a difference are entered, so d differences
+* cost O(d log n) subtree checks. Each check is an O(log n) range digest
+* and lookup in the other tree, so the total is O(d log^2 n), not
+* O(d log n). Identical trees cost one comparison.
+*/
+template<class Key, class Value>
+std::vector<Key> MerkleAVLTree<Key, Value>::diff(const MerkleAVLTree<Key, Value>& other) const
+{
+    struct Frame
+    {
+        Node<Key, Value>* node;
+        const Key* lo;      // exclusive bounds, nullptr for unbounded
+        const Key* hi;
+    };
+
+    std::vector<Key> keys;
+    std::vector<Frame> frames;
+    Frame first = { this->root_, nullptr, nullptr };
+    frames.push_back(first);
+    while (!frames.empty()){
+      Frame frame = frames.back();
+      frames.pop_back();
+      MerkleDigest theirs = other.aggregateRange(frame.lo, false, frame.hi);
+      if (frame.node == nullptr){
+        if (theirs != MerkleMonoid<Key, Value>::identity()){
+          collectBetween(other.root_, frame.lo, frame.hi, keys);
+        }
+        continue;
+      }
+      if (Base::aggregateOf(frame.node) == theirs){
+        continue;
+      }
+      if (theirs == MerkleMonoid<Key, Value>::identity()){
+        collectBetween(frame.node, nullptr, nullptr, keys);
+        continue;
+      }
+
+      const Key& key = frame.node->getKey();
+      Node<Key, Value>* match = other.internalFind(key);
+      if (match == nullptr || !(match->getValue() == frame.node->getValue())){
+        keys.push_back(key);
+      }
+      Frame right = { frame.node->getRight(), &key, frame.hi };
+      Frame left = { frame.node->getLeft(), frame.lo, &key };
+      frames.push_back(right);
+      frames.push_back(left);
+    }
+
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+#endif
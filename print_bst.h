@@ -8,59 +8,50 @@
 #define PRINT_BST_H
 
 // BST pretty-print function
-// Version 1.2
+// Version 1.3
 
-// maximum depth of tree to actually print.
+// maximum depth of tree to actually print. Also the default depth.
+// Placeholders are two digits wide, which fits every node of 6 levels.
+#ifndef PPBST_MAX_HEIGHT
 #define PPBST_MAX_HEIGHT 6
-
-// Returns the node's distance from the given root.
-// 1 means that it is the root.
-// Returns -1 (not found) if the distance is more than PPBST_MAX_HEIGHT,
-// or -2 if the tree is inconsistent.
-template<typename Key, typename Value>
-int getNodeDepth(BinarySearchTree<Key, Value> const & tree, Node<Key, Value> * root, Node<Key, Value> * node)
-{
-    int dist = 1;
-
-    while(node != root)
-    {
-        if(node == nullptr)
-        {
-            return -2;
-        }
-
-        ++dist;
-        node = node->getParent();
-
-        if(dist > PPBST_MAX_HEIGHT)
-        {
-            return -1;
-        }
-    }
-
-    return dist;
-}
+#endif
 
 // Returns the height of the subtree at root.
 // Uses recursion, not height values, so it is bulletproof
 // against incorrect heights.
-// Stops recursing after PPBST_MAX_HEIGHT calls.
+// Stops recursing after maxHeight calls.
 template<typename Key, typename Value>
-int getSubtreeHeight(Node<Key, Value> * root, int recursionDepth = 1)
+int getSubtreeHeight(Node<Key, Value> * root, int maxHeight = PPBST_MAX_HEIGHT, int recursionDepth = 1)
 {
     if(root == nullptr)
     {
         return 0;
     }
 
-    if(recursionDepth > PPBST_MAX_HEIGHT)
+    if(recursionDepth > maxHeight)
     {
         // bail out to prevent infinite loops on bad trees
         return 0;
     }
 
-    return std::max(getSubtreeHeight(root->getLeft(), recursionDepth + 1),
-                    getSubtreeHeight(root->getRight(), recursionDepth + 1)) + 1;
+    return std::max(getSubtreeHeight(root->getLeft(), maxHeight, recursionDepth + 1),
+                    getSubtreeHeight(root->getRight(), maxHeight, recursionDepth + 1)) + 1;
+}
+
+// Appends the nodes of the top maxHeight levels under root in key order.
+// Only ever visits the nodes that will be printed, so the cost does not
+// depend on the size of the rest of the tree.
+template<typename Key, typename Value>
+void getPrintedNodes(Node<Key, Value> * root, int maxHeight, std::vector<Node<Key, Value> *> & nodes, int depth = 1)
+{
+    if(root == nullptr || depth > maxHeight)
+    {
+        return;
+    }
+
+    getPrintedNodes(root->getLeft(), maxHeight, nodes, depth + 1);
+    nodes.push_back(root);
+    getPrintedNodes(root->getRight(), maxHeight, nodes, depth + 1);
 }
 
 /* Function to prettily print a BST out to the terminal.
@@ -94,6 +85,14 @@ int getSubtreeHeight(Node<Key, Value> * root, int recursionDepth = 1)
 
 template<typename Key, typename Value>
 void BinarySearchTree<Key, Value>::printRoot (Node<Key, Value>* root) const
+{
+    printRoot(root, PPBST_MAX_HEIGHT);
+}
+
+// Prints the top height levels (clamped to 1..PPBST_MAX_HEIGHT) of the
+// subtree at root. Touches only the printed nodes.
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::printRoot (Node<Key, Value>* root, int height) const
 {
     // special case for empty trees:
     if(root == nullptr)
@@ -111,13 +110,14 @@ void BinarySearchTree<Key, Value>::printRoot (Node<Key, Value>* root) const
 
     // do some initial calculations
     // ----------------------------------------------------------------------
-    uint32_t printedTreeHeight = getSubtreeHeight(root);
+    height = std::max(1, std::min(height, PPBST_MAX_HEIGHT));
+    uint32_t printedTreeHeight = getSubtreeHeight(root, height + 1);
     bool clippedFinalElements = false;
 
     // with the width of a standard terminal, we can only print 2^5 = 32 elements
-    if(printedTreeHeight > PPBST_MAX_HEIGHT)
+    if(printedTreeHeight > (uint32_t)height)
     {
-        printedTreeHeight = PPBST_MAX_HEIGHT;
+        printedTreeHeight = height;
         clippedFinalElements = true;
 
     }
@@ -127,19 +127,15 @@ void BinarySearchTree<Key, Value>::printRoot (Node<Key, Value>* root) const
 
     // get placeholders
     // ----------------------------------------------------------------------
-    std::map<Key, uint8_t> valuePlaceholders;
+    std::vector<Node<Key, Value> *> printedNodes;
+    getPrintedNodes(root, printedTreeHeight, printedNodes);
 
-    uint8_t nextPlaceHolderVal = 1;
-    for(typename BinarySearchTree<Key, Value>::iterator treeIter = this->begin(); treeIter != this->end(); ++treeIter)
+    // printedNodes is in key order, so values get the same placeholders
+    // between different calls as long as the printed part is the same
+    std::map<Node<Key, Value> *, uint8_t> valuePlaceholders;
+    for(size_t nodeIndex = 0; nodeIndex < printedNodes.size(); ++nodeIndex)
     {
-
-        if(getNodeDepth(*this, root, treeIter.current_) != -1)
-        {
-            // note; the iterator will traverse in sorted order so values should get the same placeholders between
-            // different calls as long as the tree is the same
-            valuePlaceholders.insert(std::make_pair(treeIter->first, nextPlaceHolderVal++));
-        }
-
+        valuePlaceholders.insert(std::make_pair(printedNodes[nodeIndex], (uint8_t)(nodeIndex + 1)));
     }
 
     // print tree
@@ -167,7 +163,7 @@ void BinarySearchTree<Key, Value>::printRoot (Node<Key, Value>* root) const
             }
             else
             {
-                uint16_t placeholder = valuePlaceholders[currRowNodes[elementIndex]->getItem().first];
+                uint16_t placeholder = valuePlaceholders[currRowNodes[elementIndex]];
                 std::cout << "[" << std::setfill('0') << std::setw(2) << placeholder << "]";
             }
 
@@ -265,33 +261,61 @@ void BinarySearchTree<Key, Value>::printRoot (Node<Key, Value>* root) const
     if(!std::is_same<Key, uint8_t>::value) // print placeholder explanations if needed:
     {
         std::cout << "Tree Placeholders:------------------" << std::endl;
-        for(typename std::map<Key, uint8_t>::iterator placeholdersIter = valuePlaceholders.begin(); placeholdersIter != valuePlaceholders.end(); ++placeholdersIter)
+        for(size_t nodeIndex = 0; nodeIndex < printedNodes.size(); ++nodeIndex)
         {
-            std::cout << '[' << std::setfill('0') << std::setw(2) << ((uint16_t)placeholdersIter->second) << "] -> ";
+            std::cout << '[' << std::setfill('0') << std::setw(2) << (nodeIndex + 1) << "] -> ";
 
             // print element with original cout flags
             std::cout.flags(origCoutState);
-            std::cout << '(' << placeholdersIter->first << ", ";
+            std::cout << '(' << printedNodes[nodeIndex]->getKey() << ", "
+                      << printedNodes[nodeIndex]->getValue() << ')' << std::endl;
+        }
+    }
 
-            typename BinarySearchTree<Key, Value>::iterator elementIter = this->find(placeholdersIter->first);
-            if(elementIter == this->end())
-            {
-                std::cout << "<error: lookup failed>";
-            }
-            else
-            {
-                std::cout << elementIter->second;
-            }
+    // restore original cout flags
+    std::cout.flags(origCoutState);
 
-            std::cout << ')' << std::endl;
+}
 
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::print(int height) const
+{
+    printRoot(root_, height);
+    std::cout << "\n";
+}
 
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::printAround(const Key& key) const
+{
+    printAround(key, PPBST_MAX_HEIGHT);
+}
+
+// Prints height levels centred on key: the subtree rooted (height - 1) / 2
+// levels above key's node, so the key has context on both sides. A missing
+// key centres on the node it would be inserted under. Costs one descent
+// plus the printed nodes.
+template<typename Key, typename Value>
+void BinarySearchTree<Key, Value>::printAround(const Key& key, int height) const
+{
+    Node<Key, Value>* node = nullptr;
+    for(Node<Key, Value>* current = root_; current != nullptr; )
+    {
+        node = current;
+        if(key == current->getKey())
+        {
+            break;
         }
+        current = (key < current->getKey()) ? current->getLeft() : current->getRight();
     }
 
-    // restore original cout flags
-    std::cout.flags(origCoutState);
+    for(int up = (std::max(1, std::min(height, PPBST_MAX_HEIGHT)) - 1) / 2;
+        up > 0 && node != nullptr && node->getParent() != nullptr; --up)
+    {
+        node = node->getParent();
+    }
 
+    printRoot(node, height);
+    std::cout << "\n";
 }
 
 #endif
@@ -0,0 +1,960 @@
+#ifndef RADIXTREE_H
+#define RADIXTREE_H
+
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <type_traits>
+#include "avlbst.h"
+
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#include <emmintrin.h>
+#define RADIX_SSE2 1
+#endif
+
+/**
+* The node kinds of a RadixTree. Inner nodes differ only in how they map a
+* key byte to a child, and each kind is used while it is the smallest that
+* fits: Node4 and Node16 keep sorted key bytes next to their children,
+* Node48 indexes 48 child slots by byte, and Node256 is a plain array.
+*/
+enum RadixNodeType
+{
+    RADIX_LEAF,
+    RADIX_NODE4,
+    RADIX_NODE16,
+    RADIX_NODE48,
+    RADIX_NODE256
+};
+
+struct RadixNode
+{
+    explicit RadixNode(uint8_t t) : type(t) {}
+
+    uint8_t type;
+};
+
+/**
+* The part every inner node shares. prefix holds the key bytes below the
+* parent's byte that every key under this node has in common (path
+* compression); keys are at most 8 bytes, so the whole prefix always fits
+* and is always checked.
+*/
+struct RadixInner : public RadixNode
+{
+    explicit RadixInner(uint8_t t) : RadixNode(t), prefixLength(0), count(0) {}
+
+    uint8_t prefixLength;
+    uint16_t count;         // children
+    uint8_t prefix[8];
+};
+
+struct RadixNode4 : public RadixInner
+{
+    RadixNode4() : RadixInner(RADIX_NODE4) {}
+
+    uint8_t keys[4];        // sorted
+    RadixNode* children[4];
+};
+
+struct RadixNode16 : public RadixInner
+{
+    RadixNode16() : RadixInner(RADIX_NODE16)
+    {
+      std::memset(keys, 0, sizeof(keys));
+    }
+
+    uint8_t keys[16];       // sorted
+    RadixNode* children[16];
+};
+
+struct RadixNode48 : public RadixInner
+{
+    RadixNode48() : RadixInner(RADIX_NODE48)
+    {
+      std::memset(index, 0, sizeof(index));
+      std::memset(children, 0, sizeof(children));
+    }
+
+    uint8_t index[256];     // slot + 1 for each byte present, else 0
+    RadixNode* children[48];
+};
+
+struct RadixNode256 : public RadixInner
+{
+    RadixNode256() : RadixInner(RADIX_NODE256)
+    {
+      std::memset(children, 0, sizeof(children));
+    }
+
+    RadixNode* children[256];
+};
+
+template <typename Key, typename Value>
+struct RadixLeaf : public RadixNode
+{
+    explicit RadixLeaf(const std::pair<const Key, Value>& i) : RadixNode(RADIX_LEAF), item(i) {}
+
+    std::pair<const Key, Value> item;
+};
+
+/**
+* An ordered map for integral keys, stored as an adaptive radix tree over
+* the key's bytes, most significant first (signed keys have their sign bit
+* flipped so that byte order is numeric order). A lookup reads at most one
+* inner node per key byte, whatever the size of the map, and never compares
+* whole keys until it reaches the one leaf it can end at. Inner nodes grow
+* and shrink between four sizes as children come and go, and chains of
+* single-child nodes are compressed into a prefix, so memory stays close to
+* one leaf per item.
+*
+* The surface is BinarySearchTree's: insert (overwriting), remove, find,
+* operator[] and in-order iterators, which are invalidated by any insert or
+* remove. OrderedMapFor below picks this tree for integral keys and
+* AVLTree otherwise.
+*/
+template <class Key, class Value>
+class RadixTree
+{
+    static_assert(std::is_integral<Key>::value && !std::is_same<Key, bool>::value,
+        "RadixTree needs an integral key");
+
+public:
+    typedef std::pair<const Key, Value> Item;
+
+    RadixTree();
+    ~RadixTree();
+
+    void insert(const Item& keyValuePair);
+    void remove(const Key& key);
+    void clear();
+    bool empty() const;
+    size_t size() const;
+
+protected:
+    static const int KEY_BYTES = sizeof(Key);
+
+public:
+    /**
+    * An iterator that keeps the inner nodes above the current leaf and
+    * where it is in each, so ++ is amortized O(1) without parent links.
+    */
+    class iterator
+    {
+    public:
+        iterator();
+
+        Item& operator*() const;
+        Item* operator->() const;
+
+        bool operator==(const iterator& rhs) const;
+        bool operator!=(const iterator& rhs) const;
+
+        iterator& operator++();
+
+    protected:
+        friend class RadixTree<Key, Value>;
+
+        struct Frame
+        {
+            RadixInner* node;
+            int pos;        // see RadixTree::childPos
+        };
+
+        void descend(RadixNode* n);
+
+        // every inner node on a path consumes at least one key byte
+        Frame stack_[KEY_BYTES];
+        int depth_;
+        RadixLeaf<Key, Value>* leaf_;
+    };
+
+    iterator begin() const;
+    iterator end() const;
+    iterator find(const Key& key) const;
+    Value& operator[](const Key& key);
+    Value const & operator[](const Key& key) const;
+
+protected:
+    typedef RadixLeaf<Key, Value> Leaf;
+
+    static uint64_t bitsOf(const Key& key);
+    static uint8_t byteAt(uint64_t bits, int depth);
+    static int prefixMismatch(const RadixInner* n, uint64_t bits, int depth);
+
+    static int childPos(const RadixInner* n, uint8_t byte);
+    static RadixNode** childSlot(RadixInner* n, int pos);
+    static int firstPos(const RadixInner* n);
+    static int nextPos(const RadixInner* n, int pos);
+    static void addChild(RadixNode** ref, uint8_t byte, RadixNode* child);
+    static void removeChild(RadixNode** ref, uint8_t byte);
+    static void grow(RadixNode** ref);
+    static void shrink(RadixNode** ref);
+    static void destroy(RadixNode* n);
+
+    Leaf* findLeaf(const Key& key) const;
+
+private:
+    // nodes are owned, and copying would share them
+    RadixTree(const RadixTree&);
+    RadixTree& operator=(const RadixTree&);
+
+protected:
+    RadixNode* root_;
+    size_t size_;
+};
+
+/**
+* The ordered map to use for Key: a RadixTree for integral keys and an
+* AVLTree for everything else, so code written against the shared surface
+* can pick its backend by key type.
+*/
+template <class Key, class Value>
+struct OrderedMapFor
+{
+    typedef typename std::conditional<
+        std::is_integral<Key>::value && !std::is_same<Key, bool>::value,
+        RadixTree<Key, Value>, AVLTree<Key, Value> >::type type;
+};
+
+/*
+--------------------------------------------------------------
+Begin implementations for the RadixTree::iterator class.
+---------------------------------------------------------------
+*/
+
+template<class Key, class Value>
+RadixTree<Key, Value>::iterator::iterator() :
+    depth_(0), leaf_(nullptr)
+{
+
+}
+
+template<class Key, class Value>
+typename RadixTree<Key, Value>::Item& RadixTree<Key, Value>::iterator::operator*() const
+{
+    return leaf_->item;
+}
+
+template<class Key, class Value>
+typename RadixTree<Key, Value>::Item* RadixTree<Key, Value>::iterator::operator->() const
+{
+    return &(leaf_->item);
+}
+
+template<class Key, class Value>
+bool RadixTree<Key, Value>::iterator::operator==(const iterator& rhs) const
+{
+    return leaf_ == rhs.leaf_;
+}
+
+template<class Key, class Value>
+bool RadixTree<Key, Value>::iterator::operator!=(const iterator& rhs) const
+{
+    return leaf_ != rhs.leaf_;
+}
+
+/**
+* Pushes the path from n down to its smallest leaf.
+*/
+template<class Key, class Value>
+void RadixTree<Key, Value>::iterator::descend(RadixNode* n)
+{
+    while (n->type != RADIX_LEAF){
+      RadixInner* inner = static_cast<RadixInner*>(n);
+      int pos = RadixTree<Key, Value>::firstPos(inner);
+      stack_[depth_].node = inner;
+      stack_[depth_].pos = pos;
+      depth_++;
+      n = *RadixTree<Key, Value>::childSlot(inner, pos);
+    }
+    leaf_ = static_cast<Leaf*>(n);
+}
+
+template<class Key, class Value>
+typename RadixTree<Key, Value>::iterator& RadixTree<Key, Value>::iterator::operator++()
+{
+    while (depth_ > 0){
+      Frame& top = stack_[depth_ - 1];
+      int pos = RadixTree<Key, Value>::nextPos(top.node, top.pos);
+      if (pos >= 0){
+        top.pos = pos;
+        descend(*RadixTree<Key, Value>::childSlot(top.node, pos));
+        return *this;
+      }
+      depth_--;
+    }
+    leaf_ = nullptr;
+    return *this;
+}
+
+/*
+-------------------------------------------------------------
+End implementations for the RadixTree::iterator class.
+-------------------------------------------------------------
+*/
+
+/*
+-----------------------------------------------------
+Begin implementations for the RadixTree class.
+-----------------------------------------------------
+*/
+
+template<class Key, class Value>
+RadixTree<Key, Value>::RadixTree() :
+    root_(nullptr), size_(0)
+{
+
+}
+
+template<class Key, class Value>
+RadixTree<Key, Value>::~RadixTree()
+{
+    clear();
+}
+
+/**
+* The key as an unsigned number with the same order: the sign bit of a
+* signed key is flipped, which moves negatives below zero.
+*/
+template<class Key, class Value>
+uint64_t RadixTree<Key, Value>::bitsOf(const Key& key)
+{
+    typedef typename std::make_unsigned<Key>::type Bits;
+    Bits bits = (Bits)key;
+    if (std::is_signed<Key>::value){
+      bits ^= (Bits)((Bits)1 << (8 * KEY_BYTES - 1));
+    }
+    return (uint64_t)bits;
+}
+
+/**
+* Byte depth of the key, counting from the most significant.
+*/
+template<class Key, class Value>
+uint8_t RadixTree<Key, Value>::byteAt(uint64_t bits, int depth)
+{
+    return (uint8_t)(bits >> (8 * (KEY_BYTES - 1 - depth)));
+}
+
+/**
+* How many of n's prefix bytes match the key from depth on.
+*/
+template<class Key, class Value>
+int RadixTree<Key, Value>::prefixMismatch(const RadixInner* n, uint64_t bits, int depth)
+{
+    int i = 0;
+    while (i < n->prefixLength && n->prefix[i] == byteAt(bits, depth + i)){
+      i++;
+    }
+    return i;
+}
+
+/**
+* Where n keeps its child for byte, or -1 if it has none. Positions are
+* array indices in a Node4 or Node16 and the byte itself in a Node48 or
+* Node256; in both cases they increase with the byte. Node16 compares all
+* sixteen keys at once where SSE2 is available.
+*/
+template<class Key, class Value>
+int RadixTree<Key, Value>::childPos(const RadixInner* n, uint8_t byte)
+{
+    switch (n->type){
+    case RADIX_NODE4: {
+      const RadixNode4* n4 = static_cast<const RadixNode4*>(n);
+      for (int i = 0; i < n4->count; i++){
+        if (n4->keys[i] == byte){
+          return i;
+        }
+      }
+      return -1;
+    }
+    case RADIX_NODE16: {
+      const RadixNode16* n16 = static_cast<const RadixNode16*>(n);
+#ifdef RADIX_SSE2
+      __m128i equal = _mm_cmpeq_epi8(_mm_set1_epi8((char)byte),
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(n16->keys)));
+      int mask = _mm_movemask_epi8(equal) & ((1 << n16->count) - 1);
+      return mask != 0 ? __builtin_ctz(mask) : -1;
+#else
+      for (int i = 0; i < n16->count; i++){
+        if (n16->keys[i] == byte){
+          return i;
+        }
+      }
+      return -1;
+#endif
+    }
+    case RADIX_NODE48:
+      return static_cast<const RadixNode48*>(n)->index[byte] != 0 ? byte : -1;
+    default:
+      return static_cast<const RadixNode256*>(n)->children[byte] != nullptr ? byte : -1;
+    }
+}
+
+template<class Key, class Value>
+RadixNode** RadixTree<Key, Value>::childSlot(RadixInner* n, int pos)
+{
+    switch (n->type){
+    case RADIX_NODE4:
+      return &static_cast<RadixNode4*>(n)->children[pos];
+    case RADIX_NODE16:
+      return &static_cast<RadixNode16*>(n)->children[pos];
+    case RADIX_NODE48: {
+      RadixNode48* n48 = static_cast<RadixNode48*>(n);
+      return &n48->children[n48->index[pos] - 1];
+    }
+    default:
+      return &static_cast<RadixNode256*>(n)->children[pos];
+    }
+}
+
+/**
+* The position after pos that holds a child, or -1.
+*/
+template<class Key, class Value>
+int RadixTree<Key, Value>::nextPos(const RadixInner* n, int pos)
+{
+    switch (n->type){
+    case RADIX_NODE4:
+    case RADIX_NODE16:
+      return pos + 1 < n->count ? pos + 1 : -1;
+    case RADIX_NODE48: {
+      const RadixNode48* n48 = static_cast<const RadixNode48*>(n);
+      for (int b = pos + 1; b < 256; b++){
+        if (n48->index[b] != 0){
+          return b;
+        }
+      }
+      return -1;
+    }
+    default: {
+      const RadixNode256* n256 = static_cast<const RadixNode256*>(n);
+      for (int b = pos + 1; b < 256; b++){
+        if (n256->children[b] != nullptr){
+          return b;
+        }
+      }
+      return -1;
+    }
+    }
+}
+
+template<class Key, class Value>
+int RadixTree<Key, Value>::firstPos(const RadixInner* n)
+{
+    return nextPos(n, -1);
+}
+
+/**
+* Replaces the full node at *ref with the next size up.
+*/
+template<class Key, class Value>
+void RadixTree<Key, Value>::grow(RadixNode** ref)
+{
+    RadixInner* old = static_cast<RadixInner*>(*ref);
+    RadixInner* bigger;
+    if (old->type == RADIX_NODE4){
+      RadixNode4* n4 = static_cast<RadixNode4*>(old);
+      RadixNode16* n16 = new RadixNode16;
+      std::memcpy(n16->keys, n4->keys, sizeof(n4->keys));
+      std::memcpy(n16->children, n4->children, sizeof(n4->children));
+      bigger = n16;
+    }
+    else if (old->type == RADIX_NODE16){
+      RadixNode16* n16 = static_cast<RadixNode16*>(old);
+      RadixNode48* n48 = new RadixNode48;
+      for (int i = 0; i < 16; i++){
+        n48->index[n16->keys[i]] = (uint8_t)(i + 1);
+        n48->children[i] = n16->children[i];
+      }
+      bigger = n48;
+    }
+    else {
+      RadixNode48* n48 = static_cast<RadixNode48*>(old);
+      RadixNode256* n256 = new RadixNode256;
+      for (int b = 0; b < 256; b++){
+        if (n48->index[b] != 0){
+          n256->children[b] = n48->children[n48->index[b] - 1];
+        }
+      }
+      bigger = n256;
+    }
+    bigger->prefixLength = old->prefixLength;
+    bigger->count = old->count;
+    std::memcpy(bigger->prefix, old->prefix, sizeof(old->prefix));
+    *ref = bigger;
+    switch (old->type){
+    case RADIX_NODE4: delete static_cast<RadixNode4*>(old); break;
+    case RADIX_NODE16: delete static_cast<RadixNode16*>(old); break;
+    default: delete static_cast<RadixNode48*>(old); break;
+    }
+}
+
+/**
+* Gives the inner node at *ref a child for byte, which it must not have yet.
+*/
+template<class Key, class Value>
+void RadixTree<Key, Value>::addChild(RadixNode** ref, uint8_t byte, RadixNode* child)
+{
+    RadixInner* n = static_cast<RadixInner*>(*ref);
+    if ((n->type == RADIX_NODE4 && n->count == 4) || (n->type == RADIX_NODE16 && n->count == 16)
+        || (n->type == RADIX_NODE48 && n->count == 48)){
+      grow(ref);
+      n = static_cast<RadixInner*>(*ref);
+    }
+    switch (n->type){
+    case RADIX_NODE4:
+    case RADIX_NODE16: {
+      uint8_t* keys;
+      RadixNode** children;
+      if (n->type == RADIX_NODE4){
+        keys = static_cast<RadixNode4*>(n)->keys;
+        children = static_cast<RadixNode4*>(n)->children;
+      }
+      else {
+        keys = static_cast<RadixNode16*>(n)->keys;
+        children = static_cast<RadixNode16*>(n)->children;
+      }
+      int pos = n->count;
+      while (pos > 0 && keys[pos - 1] > byte){
+        keys[pos] = keys[pos - 1];
+        children[pos] = children[pos - 1];
+        pos--;
+      }
+      keys[pos] = byte;
+      children[pos] = child;
+      break;
+    }
+    case RADIX_NODE48: {
+      //removals leave holes, so take the first free slot
+      RadixNode48* n48 = static_cast<RadixNode48*>(n);
+      int slot = 0;
+      while (n48->children[slot] != nullptr){
+        slot++;
+      }
+      n48->children[slot] = child;
+      n48->index[byte] = (uint8_t)(slot + 1);
+      break;
+    }
+    default:
+      static_cast<RadixNode256*>(n)->children[byte] = child;
+      break;
+    }
+    n->count++;
+}
+
+/**
+* Replaces the inner node at *ref with the next size down once it has few
+* enough children, or with its only child once it has one. The thresholds
+* sit below the growth points, so a node at a boundary does not flip back
+* and forth.
+*/
+template<class Key, class Value>
+void RadixTree<Key, Value>::shrink(RadixNode** ref)
+{
+    RadixInner* old = static_cast<RadixInner*>(*ref);
+    if (old->type == RADIX_NODE4){
+      RadixNode4* n4 = static_cast<RadixNode4*>(old);
+      if (n4->count != 1){
+        return;
+      }
+      RadixNode* child = n4->children[0];
+      if (child->type != RADIX_LEAF){
+        //the child's prefix becomes ours, then its key byte, then its own
+        RadixInner* inner = static_cast<RadixInner*>(child);
+        uint8_t prefix[8];
+        int length = n4->prefixLength;
+        std::memcpy(prefix, n4->prefix, length);
+        prefix[length++] = n4->keys[0];
+        std::memcpy(prefix + length, inner->prefix, inner->prefixLength);
+        length += inner->prefixLength;
+        std::memcpy(inner->prefix, prefix, length);
+        inner->prefixLength = (uint8_t)length;
+      }
+      *ref = child;
+      delete n4;
+      return;
+    }
+
+    RadixInner* smaller;
+    if (old->type == RADIX_NODE16){
+      if (old->count > 3){
+        return;
+      }
+      RadixNode16* n16 = static_cast<RadixNode16*>(old);
+      RadixNode4* n4 = new RadixNode4;
+      std::memcpy(n4->keys, n16->keys, n16->count);
+      std::memcpy(n4->children, n16->children, n16->count * sizeof(RadixNode*));
+      smaller = n4;
+    }
+    else if (old->type == RADIX_NODE48){
+      if (old->count > 12){
+        return;
+      }
+      RadixNode48* n48 = static_cast<RadixNode48*>(old);
+      RadixNode16* n16 = new RadixNode16;
+      int i = 0;
+      for (int b = 0; b < 256; b++){
+        if (n48->index[b] != 0){
+          n16->keys[i] = (uint8_t)b;
+          n16->children[i] = n48->children[n48->index[b] - 1];
+          i++;
+        }
+      }
+      smaller = n16;
+    }
+    else {
+      if (old->count > 36){
+        return;
+      }
+      RadixNode256* n256 = static_cast<RadixNode256*>(old);
+      RadixNode48* n48 = new RadixNode48;
+      int slot = 0;
+      for (int b = 0; b < 256; b++){
+        if (n256->children[b] != nullptr){
+          n48->children[slot] = n256->children[b];
+          n48->index[b] = (uint8_t)(++slot);
+        }
+      }
+      smaller = n48;
+    }
+    smaller->prefixLength = old->prefixLength;
+    smaller->count = old->count;
+    std::memcpy(smaller->prefix, old->prefix, sizeof(old->prefix));
+    *ref = smaller;
+    switch (old->type){
+    case RADIX_NODE16: delete static_cast<RadixNode16*>(old); break;
+    case RADIX_NODE48: delete static_cast<RadixNode48*>(old); break;
+    default: delete static_cast<RadixNode256*>(old); break;
+    }
+}
+
+/**
+* Drops the inner node at *ref's child for byte (without deleting it).
+*/
+template<class Key, class Value>
+void RadixTree<Key, Value>::removeChild(RadixNode** ref, uint8_t byte)
+{
+    RadixInner* n = static_cast<RadixInner*>(*ref);
+    int pos = childPos(n, byte);
+    switch (n->type){
+    case RADIX_NODE4:
+    case RADIX_NODE16: {
+      uint8_t* keys;
+      RadixNode** children;
+      if (n->type == RADIX_NODE4){
+        keys = static_cast<RadixNode4*>(n)->keys;
+        children = static_cast<RadixNode4*>(n)->children;
+      }
+      else {
+        keys = static_cast<RadixNode16*>(n)->keys;
+        children = static_cast<RadixNode16*>(n)->children;
+      }
+      for (int i = pos + 1; i < n->count; i++){
+        keys[i - 1] = keys[i];
+        children[i - 1] = children[i];
+      }
+      break;
+    }
+    case RADIX_NODE48: {
+      RadixNode48* n48 = static_cast<RadixNode48*>(n);
+      n48->children[n48->index[byte] - 1] = nullptr;
+      n48->index[byte] = 0;
+      break;
+    }
+    default:
+      static_cast<RadixNode256*>(n)->children[byte] = nullptr;
+      break;
+    }
+    n->count--;
+    shrink(ref);
+}
+
+template<class Key, class Value>
+void RadixTree<Key, Value>::destroy(RadixNode* n)
+{
+    switch (n->type){
+    case RADIX_LEAF:
+      delete static_cast<Leaf*>(n);
+      return;
+    case RADIX_NODE4: {
+      RadixNode4* n4 = static_cast<RadixNode4*>(n);
+      for (int i = 0; i < n4->count; i++){
+        destroy(n4->children[i]);
+      }
+      delete n4;
+      return;
+    }
+    case RADIX_NODE16: {
+      RadixNode16* n16 = static_cast<RadixNode16*>(n);
+      for (int i = 0; i < n16->count; i++){
+        destroy(n16->children[i]);
+      }
+      delete n16;
+      return;
+    }
+    case RADIX_NODE48: {
+      RadixNode48* n48 = static_cast<RadixNode48*>(n);
+      for (int i = 0; i < 48; i++){
+        if (n48->children[i] != nullptr){
+          destroy(n48->children[i]);
+        }
+      }
+      delete n48;
+      return;
+    }
+    default: {
+      RadixNode256* n256 = static_cast<RadixNode256*>(n);
+      for (int b = 0; b < 256; b++){
+        if (n256->children[b] != nullptr){
+          destroy(n256->children[b]);
+        }
+      }
+      delete n256;
+      return;
+    }
+    }
+}
+
+/**
+* If key is already in the tree, the current value is overwritten
+* with the updated value.
+*/
+template<class Key, class Value>
+void RadixTree<Key, Value>::insert(const Item& keyValuePair)
+{
+    uint64_t bits = bitsOf(keyValuePair.first);
+    RadixNode** ref = &root_;
+    int depth = 0;
+    while (*ref != nullptr){
+      RadixNode* node = *ref;
+      if (node->type == RADIX_LEAF){
+        Leaf* leaf = static_cast<Leaf*>(node);
+        uint64_t leafBits = bitsOf(leaf->item.first);
+        if (leafBits == bits){ //same key, so rewrite value
+          leaf->item.second = keyValuePair.second;
+          return;
+        }
+        //a Node4 over both leaves, holding the bytes they share
+        RadixNode4* split = new RadixNode4;
+        int differ = depth;
+        while (byteAt(leafBits, differ) == byteAt(bits, differ)){
+          split->prefix[differ - depth] = byteAt(bits, differ);
+          differ++;
+        }
+        split->prefixLength = (uint8_t)(differ - depth);
+        *ref = split;
+        addChild(ref, byteAt(leafBits, differ), leaf);
+        addChild(ref, byteAt(bits, differ), new Leaf(keyValuePair));
+        size_++;
+        return;
+      }
+
+      RadixInner* inner = static_cast<RadixInner*>(node);
+      int matched = prefixMismatch(inner, bits, depth);
+      if (matched < inner->prefixLength){
+        //a Node4 over the shared part of the prefix, with the old node below
+        RadixNode4* split = new RadixNode4;
+        std::memcpy(split->prefix, inner->prefix, matched);
+        split->prefixLength = (uint8_t)matched;
+        uint8_t innerByte = inner->prefix[matched];
+        int rest = inner->prefixLength - matched - 1;
+        std::memmove(inner->prefix, inner->prefix + matched + 1, rest);
+        inner->prefixLength = (uint8_t)rest;
+        *ref = split;
+        addChild(ref, innerByte, inner);
+        addChild(ref, byteAt(bits, depth + matched), new Leaf(keyValuePair));
+        size_++;
+        return;
+      }
+      depth += inner->prefixLength;
+      int pos = childPos(inner, byteAt(bits, depth));
+      if (pos < 0){
+        addChild(ref, byteAt(bits, depth), new Leaf(keyValuePair));
+        size_++;
+        return;
+      }
+      ref = childSlot(inner, pos);
+      depth++;
+    }
+    root_ = new Leaf(keyValuePair);
+    size_++;
+}
+
+template<class Key, class Value>
+void RadixTree<Key, Value>::remove(const Key& key)
+{
+    uint64_t bits = bitsOf(key);
+    RadixNode** parentRef = nullptr;
+    uint8_t parentByte = 0;
+    RadixNode** ref = &root_;
+    int depth = 0;
+    while (*ref != nullptr){
+      RadixNode* node = *ref;
+      if (node->type == RADIX_LEAF){
+        Leaf* leaf = static_cast<Leaf*>(node);
+        if (bitsOf(leaf->item.first) != bits){
+          //nothing to remove
+          return;
+        }
+        if (parentRef == nullptr){
+          root_ = nullptr;
+        }
+        else {
+          removeChild(parentRef, parentByte);
+        }
+        delete leaf;
+        size_--;
+        return;
+      }
+
+      RadixInner* inner = static_cast<RadixInner*>(node);
+      if (prefixMismatch(inner, bits, depth) < inner->prefixLength){
+        return;
+      }
+      depth += inner->prefixLength;
+      int pos = childPos(inner, byteAt(bits, depth));
+      if (pos < 0){
+        return;
+      }
+      parentRef = ref;
+      parentByte = byteAt(bits, depth);
+      ref = childSlot(inner, pos);
+      depth++;
+    }
+}
+
+template<class Key, class Value>
+void RadixTree<Key, Value>::clear()
+{
+    if (root_ != nullptr){
+      destroy(root_);
+    }
+    root_ = nullptr;
+    size_ = 0;
+}
+
+template<class Key, class Value>
+bool RadixTree<Key, Value>::empty() const
+{
+    return root_ == nullptr;
+}
+
+template<class Key, class Value>
+size_t RadixTree<Key, Value>::size() const
+{
+    return size_;
+}
+
+/**
+* A leaf reached by the byte descent may still hold a different key: a
+* leaf left under a collapsed node skips that node's bytes. So the key is
+* compared once, at the end.
+*/
+template<class Key, class Value>
+typename RadixTree<Key, Value>::Leaf* RadixTree<Key, Value>::findLeaf(const Key& key) const
+{
+    uint64_t bits = bitsOf(key);
+    RadixNode* node = root_;
+    int depth = 0;
+    while (node != nullptr && node->type != RADIX_LEAF){
+      RadixInner* inner = static_cast<RadixInner*>(node);
+      if (prefixMismatch(inner, bits, depth) < inner->prefixLength){
+        return nullptr;
+      }
+      depth += inner->prefixLength;
+      int pos = childPos(inner, byteAt(bits, depth));
+      if (pos < 0){
+        return nullptr;
+      }
+      node = *childSlot(inner, pos);
+      depth++;
+    }
+    if (node == nullptr || !(static_cast<Leaf*>(node)->item.first == key)){
+      return nullptr;
+    }
+    return static_cast<Leaf*>(node);
+}
+
+template<class Key, class Value>
+typename RadixTree<Key, Value>::iterator RadixTree<Key, Value>::begin() const
+{
+    iterator it;
+    if (root_ != nullptr){
+      it.descend(root_);
+    }
+    return it;
+}
+
+template<class Key, class Value>
+typename RadixTree<Key, Value>::iterator RadixTree<Key, Value>::end() const
+{
+    return iterator();
+}
+
+/**
+* Returns an iterator to key, or end(). The descent records its path so
+* that the iterator can advance from there.
+*/
+template<class Key, class Value>
+typename RadixTree<Key, Value>::iterator RadixTree<Key, Value>::find(const Key& key) const
+{
+    uint64_t bits = bitsOf(key);
+    iterator it;
+    RadixNode* node = root_;
+    int depth = 0;
+    while (node != nullptr && node->type != RADIX_LEAF){
+      RadixInner* inner = static_cast<RadixInner*>(node);
+      if (prefixMismatch(inner, bits, depth) < inner->prefixLength){
+        return end();
+      }
+      depth += inner->prefixLength;
+      int pos = childPos(inner, byteAt(bits, depth));
+      if (pos < 0){
+        return end();
+      }
+      it.stack_[it.depth_].node = inner;
+      it.stack_[it.depth_].pos = pos;
+      it.depth_++;
+      node = *childSlot(inner, pos);
+      depth++;
+    }
+    if (node == nullptr || !(static_cast<Leaf*>(node)->item.first == key)){
+      return end();
+    }
+    it.leaf_ = static_cast<Leaf*>(node);
+    return it;
+}
+
+/**
+ * @precondition The key exists in the map
+ * Returns the value associated with the key
+ */
+template<class Key, class Value>
+Value& RadixTree<Key, Value>::operator[](const Key& key)
+{
+    Leaf* leaf = findLeaf(key);
+    if(leaf == nullptr) throw std::out_of_range("Invalid key");
+    return leaf->item.second;
+}
+
+template<class Key, class Value>
+Value const & RadixTree<Key, Value>::operator[](const Key& key) const
+{
+    Leaf* leaf = findLeaf(key);
+    if(leaf == nullptr) throw std::out_of_range("Invalid key");
+    return leaf->item.second;
+}
+
+/*
+---------------------------------------------------
+End implementations for the RadixTree class.
+---------------------------------------------------
+*/
+
+#endif
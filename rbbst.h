@@ -0,0 +1,556 @@
+#ifndef RBBST_H
+#define RBBST_H
+
+#include <iostream>
+#include <exception>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include "bst.h"
+
+/**
+* A special kind of node for a Red Black tree. The colour is packed into the
+* lowest bit of the inherited parent pointer (nodes are always at least
+* pointer-aligned, so that bit is otherwise zero), which keeps an RBNode the
+* same size as a plain Node instead of paying for a padded colour field the
+* way AVLNode pays for balance_.
+*/
+template <typename Key, typename Value>
+class RBNode : public Node<Key, Value>
+{
+public:
+    enum Color { RED = 0, BLACK = 1 };
+
+    // Constructor/destructor.
+    RBNode(const Key& key, const Value& value, RBNode<Key, Value>* parent);
+    virtual ~RBNode();
+
+    // Getter/setter for the node's colour.
+    Color getColor() const;
+    void setColor(Color color);
+    bool isRed() const;
+
+    // Hides Node::setParent so that the colour bit survives re-parenting.
+    // Code that re-parents through a plain Node* (BinarySearchTree::nodeSwap,
+    // BinarySearchTree::cloneFrom) clears the bit, and RedBlackTree::nodeSwap
+    // and RedBlackTree::nodeCloned restore it afterwards.
+    void setParent(Node<Key, Value>* parent);
+
+    // Getters for parent, left, and right. getParent must strip the colour
+    // bit before handing the pointer out.
+    virtual RBNode<Key, Value>* getParent() const override;
+    virtual RBNode<Key, Value>* getLeft() const override;
+    virtual RBNode<Key, Value>* getRight() const override;
+
+protected:
+    static const uintptr_t COLOR_MASK = 1;
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the RBNode class.
+  -------------------------------------------------
+*/
+
+/**
+* An explicit constructor to initialize the elements by calling the base class constructor.
+* New nodes are red.
+*/
+template<class Key, class Value>
+RBNode<Key, Value>::RBNode(const Key& key, const Value& value, RBNode<Key, Value> *parent) :
+    Node<Key, Value>(key, value, parent)
+{
+
+}
+
+/**
+* A destructor which does nothing.
+*/
+template<class Key, class Value>
+RBNode<Key, Value>::~RBNode()
+{
+
+}
+
+/**
+* A getter for the colour of a RBNode.
+*/
+template<class Key, class Value>
+typename RBNode<Key, Value>::Color RBNode<Key, Value>::getColor() const
+{
+    return (reinterpret_cast<uintptr_t>(this->parent_) & COLOR_MASK) ? BLACK : RED;
+}
+
+/**
+* A setter for the colour of a RBNode.
+*/
+template<class Key, class Value>
+void RBNode<Key, Value>::setColor(Color color)
+{
+    uintptr_t bits = reinterpret_cast<uintptr_t>(this->parent_) & ~COLOR_MASK;
+    this->parent_ = reinterpret_cast<Node<Key, Value>*>(bits | static_cast<uintptr_t>(color));
+}
+
+/**
+* Returns true if the node is red.
+*/
+template<class Key, class Value>
+bool RBNode<Key, Value>::isRed() const
+{
+    return getColor() == RED;
+}
+
+/**
+* Sets the parent while keeping the colour bit.
+*/
+template<class Key, class Value>
+void RBNode<Key, Value>::setParent(Node<Key, Value>* parent)
+{
+    Color color = getColor();
+    this->parent_ = parent;
+    setColor(color);
+}
+
+/**
+* An overridden function for getting the parent, which masks off the colour bit.
+*/
+template<class Key, class Value>
+RBNode<Key, Value> *RBNode<Key, Value>::getParent() const
+{
+    uintptr_t bits = reinterpret_cast<uintptr_t>(this->parent_) & ~COLOR_MASK;
+    return reinterpret_cast<RBNode<Key, Value>*>(bits);
+}
+
+/**
+* Overridden for the same reasons as in AVLNode.
+*/
+template<class Key, class Value>
+RBNode<Key, Value> *RBNode<Key, Value>::getLeft() const
+{
+    return static_cast<RBNode<Key, Value>*>(this->left_);
+}
+
+/**
+* Overridden for the same reasons as in AVLNode.
+*/
+template<class Key, class Value>
+RBNode<Key, Value> *RBNode<Key, Value>::getRight() const
+{
+    return static_cast<RBNode<Key, Value>*>(this->right_);
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the RBNode class.
+  -----------------------------------------------
+*/
+
+/**
+* A Red Black tree. Compared to AVLTree it does at most two rotations per
+* insert and three per remove (the rest of the fix-up is recolouring), which
+* makes it the better choice for delete-heavy workloads.
+*/
+template <class Key, class Value>
+class RedBlackTree : public BinarySearchTree<Key, Value>
+{
+public:
+    RedBlackTree();
+    RedBlackTree(RedBlackTree&& other) noexcept;
+    RedBlackTree& operator=(RedBlackTree&& other) noexcept;
+    void swap(RedBlackTree& other) noexcept;
+    virtual void insert (const std::pair<const Key, Value> &new_item);
+    virtual void remove(const Key& key);
+    RedBlackTree clone() const;
+protected:
+    virtual void nodeSwap( RBNode<Key,Value>* n1, RBNode<Key,Value>* n2);
+    virtual void removeNode(Node<Key, Value>* n);
+    virtual size_t nodeBytes() const;
+    virtual Node<Key, Value>* cloneNode(const Node<Key, Value>* src);
+    virtual void nodeCloned(Node<Key, Value>* copy, const Node<Key, Value>* src);
+
+    void rotateLeft(RBNode<Key,Value>* n);
+    void rotateRight(RBNode<Key, Value>* n);
+
+    void insertFix(RBNode<Key,Value>* n);
+    void removeFix(RBNode<Key, Value>* node, RBNode<Key, Value>* parent);
+
+    static bool isRed(RBNode<Key, Value>* n);
+};
+
+template<class Key, class Value>
+size_t RedBlackTree<Key, Value>::nodeBytes() const
+{
+    return sizeof(RBNode<Key, Value>);
+}
+
+template<class Key, class Value>
+RedBlackTree<Key, Value>::RedBlackTree()
+{
+
+}
+
+/**
+* Colours live in the nodes, so they move with them.
+*/
+template<class Key, class Value>
+RedBlackTree<Key, Value>::RedBlackTree(RedBlackTree&& other) noexcept :
+    BinarySearchTree<Key, Value>(static_cast<BinarySearchTree<Key, Value>&&>(other))
+{
+
+}
+
+template<class Key, class Value>
+RedBlackTree<Key, Value>& RedBlackTree<Key, Value>::operator=(RedBlackTree&& other) noexcept
+{
+    RedBlackTree<Key, Value> old(std::move(other));
+    swap(old);
+    return *this;
+}
+
+template<class Key, class Value>
+void RedBlackTree<Key, Value>::swap(RedBlackTree& other) noexcept
+{
+    BinarySearchTree<Key, Value>::swap(static_cast<BinarySearchTree<Key, Value>&>(other));
+}
+
+/**
+* Copies the shape and every colour as they are.
+*/
+template<class Key, class Value>
+RedBlackTree<Key, Value> RedBlackTree<Key, Value>::clone() const
+{
+    RedBlackTree<Key, Value> copy;
+    copy.cloneFrom(*this);
+    return copy;
+}
+
+template<class Key, class Value>
+Node<Key, Value>* RedBlackTree<Key, Value>::cloneNode(const Node<Key, Value>* src)
+{
+    return new RBNode<Key, Value>(src->getKey(), src->getValue(), nullptr);
+}
+
+/**
+* cloneFrom links the copy through Node::setParent, which clears the
+* colour bit, so the colour is only set once the copy is in place.
+*/
+template<class Key, class Value>
+void RedBlackTree<Key, Value>::nodeCloned(Node<Key, Value>* copy, const Node<Key, Value>* src)
+{
+    static_cast<RBNode<Key, Value>*>(copy)->setColor(static_cast<const RBNode<Key, Value>*>(src)->getColor());
+    BinarySearchTree<Key, Value>::nodeCloned(copy, src);
+}
+
+/**
+* Null children count as black.
+*/
+template<class Key, class Value>
+bool RedBlackTree<Key, Value>::isRed(RBNode<Key, Value>* n)
+{
+    return n != nullptr && n->isRed();
+}
+
+/*
+ * If key is already in the tree, the current value is overwritten
+ * with the updated value.
+ */
+template<class Key, class Value>
+void RedBlackTree<Key, Value>::insert (const std::pair<const Key, Value> &new_item)
+{
+    RBNode<Key, Value>* current = static_cast<RBNode<Key, Value>*>(this->root_);
+    RBNode<Key, Value>* prev = nullptr;
+
+    //find place of insertion
+    while (current != nullptr){
+      prev = current;
+      if (new_item.first < current->getKey()){
+        current = current->getLeft();
+      }
+      else if (current->getKey() < new_item.first){
+        current = current->getRight();
+      }
+      else { //same key, so rewrite value
+        current->setValue(new_item.second);
+        return;
+      }
+    }
+
+    RBNode<Key, Value>* node = new RBNode<Key, Value>(new_item.first, new_item.second, prev);
+    if (prev == nullptr){
+      this->root_ = node;
+    }
+    else if (node->getKey() < prev->getKey()){
+      prev->setLeft(node);
+    }
+    else {
+      prev->setRight(node);
+    }
+    this->nodeLinked(node);
+
+    insertFix(node);
+}
+
+template<class Key, class Value>
+void RedBlackTree<Key, Value>::insertFix (RBNode<Key, Value>* node){
+  /*
+  - while parent p is red (so grandparent g exists and is black)
+  - case 1: uncle is red, recolour p, u black and g red, continue from g
+  - case 2: node is an inner grandchild, rotate at p to make it outer
+  - case 3: node is an outer grandchild, rotate at g and swap colours
+  - root is always black
+  */
+
+  while (isRed(node->getParent())){
+    RBNode<Key, Value>* parent = node->getParent();
+    RBNode<Key, Value>* gparent = parent->getParent();
+
+    if (parent == gparent->getLeft()){
+      RBNode<Key, Value>* uncle = gparent->getRight();
+      if (isRed(uncle)){
+        parent->setColor(RBNode<Key, Value>::BLACK);
+        uncle->setColor(RBNode<Key, Value>::BLACK);
+        gparent->setColor(RBNode<Key, Value>::RED);
+        node = gparent;
+        continue;
+      }
+      if (node == parent->getRight()){ //zigzag
+        rotateLeft(parent);
+        node = parent;
+        parent = node->getParent();
+      }
+      rotateRight(gparent);
+      parent->setColor(RBNode<Key, Value>::BLACK);
+      gparent->setColor(RBNode<Key, Value>::RED);
+    }
+    else {
+      RBNode<Key, Value>* uncle = gparent->getLeft();
+      if (isRed(uncle)){
+        parent->setColor(RBNode<Key, Value>::BLACK);
+        uncle->setColor(RBNode<Key, Value>::BLACK);
+        gparent->setColor(RBNode<Key, Value>::RED);
+        node = gparent;
+        continue;
+      }
+      if (node == parent->getLeft()){ //zigzag
+        rotateRight(parent);
+        node = parent;
+        parent = node->getParent();
+      }
+      rotateLeft(gparent);
+      parent->setColor(RBNode<Key, Value>::BLACK);
+      gparent->setColor(RBNode<Key, Value>::RED);
+    }
+  }
+  static_cast<RBNode<Key, Value>*>(this->root_)->setColor(RBNode<Key, Value>::BLACK);
+}
+
+/*
+ * As with the other trees, if a node has 2 children we
+ * swap with the predecessor and then remove.
+ */
+template<class Key, class Value>
+void RedBlackTree<Key, Value>::remove(const Key& key)
+{
+    RBNode<Key, Value>* node = static_cast<RBNode<Key, Value>*>(this->internalFind(key));
+    if (node == nullptr){
+      //nothing to remove
+      return;
+    }
+    removeNode(node);
+}
+
+/**
+* Unlinks and deletes a node that is known to be in the tree, then
+* restores the colour invariants.
+*/
+template<class Key, class Value>
+void RedBlackTree<Key, Value>::removeNode(Node<Key, Value>* n)
+{
+    RBNode<Key, Value>* node = static_cast<RBNode<Key, Value>*>(n);
+
+    if (node->getLeft() != nullptr && node->getRight() != nullptr){
+      RBNode<Key, Value>* pred = static_cast<RBNode<Key, Value>*>(this->predecessor(node));
+      nodeSwap(node, pred);
+    }
+    this->nodeUnlinking(node);
+
+    //either 1 or 0 child case
+    RBNode<Key, Value>* parent = node->getParent();
+    RBNode<Key, Value>* child = node->getLeft() != nullptr ? node->getLeft() : node->getRight();
+
+    if (child != nullptr){
+      child->setParent(parent);
+    }
+    if (parent == nullptr){
+      this->root_ = child;
+    }
+    else if (node == parent->getLeft()){
+      parent->setLeft(child);
+    }
+    else {
+      parent->setRight(child);
+    }
+
+    bool removedBlack = !node->isRed();
+    delete node;
+
+    //removing a red node never changes black heights
+    if (removedBlack){
+      removeFix(child, parent);
+    }
+}
+
+template<typename Key, typename Value>
+void RedBlackTree<Key, Value>::removeFix(RBNode<Key, Value>* node, RBNode<Key, Value>* parent){
+  /*
+  node carries an extra black (it may be null, hence the separate parent)
+  - if node is red, paint it black and stop
+  - case 1: sibling s is red, rotate at p so the sibling becomes black
+  - case 2: s and both its children black, recolour s red, move up to p
+  - case 3: s's far child black, near child red, rotate at s
+  - case 4: s's far child red, rotate at p, done
+  */
+
+  while (node != this->root_ && !isRed(node)){
+    if (node == parent->getLeft()){
+      RBNode<Key, Value>* sibling = parent->getRight();
+      if (isRed(sibling)){
+        sibling->setColor(RBNode<Key, Value>::BLACK);
+        parent->setColor(RBNode<Key, Value>::RED);
+        rotateLeft(parent);
+        sibling = parent->getRight();
+      }
+      if (!isRed(sibling->getLeft()) && !isRed(sibling->getRight())){
+        sibling->setColor(RBNode<Key, Value>::RED);
+        node = parent;
+        parent = node->getParent();
+        continue;
+      }
+      if (!isRed(sibling->getRight())){
+        sibling->getLeft()->setColor(RBNode<Key, Value>::BLACK);
+        sibling->setColor(RBNode<Key, Value>::RED);
+        rotateRight(sibling);
+        sibling = parent->getRight();
+      }
+      sibling->setColor(parent->getColor());
+      parent->setColor(RBNode<Key, Value>::BLACK);
+      sibling->getRight()->setColor(RBNode<Key, Value>::BLACK);
+      rotateLeft(parent);
+      node = static_cast<RBNode<Key, Value>*>(this->root_);
+    }
+    else {
+      RBNode<Key, Value>* sibling = parent->getLeft();
+      if (isRed(sibling)){
+        sibling->setColor(RBNode<Key, Value>::BLACK);
+        parent->setColor(RBNode<Key, Value>::RED);
+        rotateRight(parent);
+        sibling = parent->getLeft();
+      }
+      if (!isRed(sibling->getLeft()) && !isRed(sibling->getRight())){
+        sibling->setColor(RBNode<Key, Value>::RED);
+        node = parent;
+        parent = node->getParent();
+        continue;
+      }
+      if (!isRed(sibling->getLeft())){
+        sibling->getRight()->setColor(RBNode<Key, Value>::BLACK);
+        sibling->setColor(RBNode<Key, Value>::RED);
+        rotateLeft(sibling);
+        sibling = parent->getLeft();
+      }
+      sibling->setColor(parent->getColor());
+      parent->setColor(RBNode<Key, Value>::BLACK);
+      sibling->getLeft()->setColor(RBNode<Key, Value>::BLACK);
+      rotateRight(parent);
+      node = static_cast<RBNode<Key, Value>*>(this->root_);
+    }
+  }
+  if (node != nullptr){
+    node->setColor(RBNode<Key, Value>::BLACK);
+  }
+}
+
+template<typename Key, typename Value>
+void RedBlackTree<Key, Value>::rotateLeft(RBNode<Key, Value>* node){
+  RBNode<Key, Value>* rchild = node->getRight();
+  RBNode<Key, Value>* parent = node->getParent(); //could be null
+
+  rchild->setParent(parent);
+  if (parent == nullptr){
+    this->root_ = rchild;
+  }
+  else if (node == parent->getRight()){
+    parent->setRight(rchild);
+  }
+  else { //node is left child
+    parent->setLeft(rchild);
+  }
+
+  node->setRight(rchild->getLeft());
+  if (rchild->getLeft() != nullptr){
+    rchild->getLeft()->setParent(node);
+  }
+
+  rchild->setLeft(node);
+  node->setParent(rchild);
+}
+
+template<typename Key, typename Value>
+void RedBlackTree<Key, Value>::rotateRight(RBNode<Key, Value>* node){
+  RBNode<Key, Value>* lchild = node->getLeft();
+  RBNode<Key, Value>* parent = node->getParent(); //could be null
+
+  lchild->setParent(parent);
+  if (parent == nullptr){
+    this->root_ = lchild;
+  }
+  else if (node == parent->getRight()){
+    parent->setRight(lchild);
+  }
+  else { //node is left child
+    parent->setLeft(lchild);
+  }
+
+  node->setLeft(lchild->getRight());
+  if (lchild->getRight() != nullptr){
+    lchild->getRight()->setParent(node);
+  }
+
+  lchild->setRight(node);
+  node->setParent(lchild);
+}
+
+/**
+* The base nodeSwap re-parents through Node::setParent, which clears the
+* colour bit on n1, n2 and their children, so colours are saved first and
+* restored afterwards (with n1 and n2 trading colours along with positions).
+*/
+template<class Key, class Value>
+void RedBlackTree<Key, Value>::nodeSwap( RBNode<Key,Value>* n1, RBNode<Key,Value>* n2)
+{
+    if((n1 == n2) || (n1 == nullptr) || (n2 == nullptr) ) {
+        return;
+    }
+    RBNode<Key, Value>* touched[6] = { n1, n2, n1->getLeft(), n1->getRight(),
+                                       n2->getLeft(), n2->getRight() };
+    typename RBNode<Key, Value>::Color colors[6];
+    for (int i = 2; i < 6; i++){
+      if (touched[i] == n1 || touched[i] == n2){
+        touched[i] = nullptr; //adjacent swap, already covered
+      }
+    }
+    for (int i = 0; i < 6; i++){
+      colors[i] = touched[i] != nullptr ? touched[i]->getColor() : RBNode<Key, Value>::BLACK;
+    }
+    std::swap(colors[0], colors[1]);
+
+    BinarySearchTree<Key, Value>::nodeSwap(n1, n2);
+
+    for (int i = 0; i < 6; i++){
+      if (touched[i] != nullptr){
+        touched[i]->setColor(colors[i]);
+      }
+    }
+}
+
+#endif
@@ -0,0 +1,522 @@
+#ifndef SHARDEDAVL_H
+#define SHARDEDAVL_H
+
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "avlbst.h"
+
+/**
+* An ordered map for many writer threads, split by key range into shards
+* that are each an AVLTree with its own lock. Shard i holds the keys in
+* [bounds[i - 1], bounds[i]), with the first and last shards unbounded
+* below and above, so writers to different ranges never wait for each
+* other. insert, remove, find, contains and operator[] lock one shard and
+* may be called from any number of threads at once.
+*
+* The bounds can be moved while the map is in use. rebalance() finds the
+* shard taking the most writes and, when it is hot enough, hands half of
+* its items to its quieter neighbour. The routing table that maps a key to
+* a shard is read without locking: a rebalance publishes a new table
+* rather than changing one in use, and an operation that was routed by a
+* stale table notices under the shard lock (each shard knows its own
+* bounds) and routes again. Old tables are kept until the map is destroyed,
+* which costs one bounds vector per rebalance.
+*
+* forEach visits every item in key order and is safe to run alongside
+* writers. The iterators are for when no other thread is writing.
+*/
+template <class Key, class Value>
+class ShardedAVLTree
+{
+protected:
+    /**
+    * An AVLTree that keeps its item count through the link hooks.
+    */
+    class ShardTree : public AVLTree<Key, Value>
+    {
+    public:
+        ShardTree() : count_(0) {}
+
+        size_t size() const { return count_; }
+        virtual void clear()
+        {
+          AVLTree<Key, Value>::clear();
+          count_ = 0;
+        }
+
+    protected:
+        virtual void nodeLinked(Node<Key, Value>* n)
+        {
+          AVLTree<Key, Value>::nodeLinked(n);
+          count_++;
+        }
+        virtual void nodeUnlinking(Node<Key, Value>* n)
+        {
+          AVLTree<Key, Value>::nodeUnlinking(n);
+          count_--;
+        }
+        virtual size_t treeBytes() const
+        {
+          return sizeof(ShardTree);
+        }
+
+        size_t count_;
+    };
+
+    struct Shard
+    {
+        Shard() : lo(nullptr), hi(nullptr), writes(0) {}
+
+        bool owns(const Key& key) const
+        {
+          return (lo == nullptr || !(key < *lo)) && (hi == nullptr || key < *hi);
+        }
+
+        std::mutex lock;
+        ShardTree tree;
+        // bounds, pointing into a routing table; nullptr for unbounded
+        const Key* lo;
+        const Key* hi;
+        uint64_t writes;    // since the last rebalance
+    };
+
+    struct Routing
+    {
+        std::vector<Key> bounds;
+    };
+
+public:
+    typedef typename AVLTree<Key, Value>::iterator ShardIterator;
+
+    explicit ShardedAVLTree(const std::vector<Key>& bounds);
+
+    void insert(const std::pair<const Key, Value>& keyValuePair);
+    void remove(const Key& key);
+    bool find(const Key& key, Value& value) const;
+    bool contains(const Key& key) const;
+    // a copy, since a reference could outlive the shard lock
+    Value operator[](const Key& key) const;
+    void clear();
+    bool empty() const;
+    size_t size() const;
+
+    size_t shardCount() const;
+    size_t shardSize(size_t shard) const;
+    bool rebalance(double skew = 2.0);
+
+    template<typename Fn>
+    void forEach(Fn fn) const;
+
+    /**
+    * Walks the shards' AVLTree iterators one shard after another. Not safe
+    * while other threads modify the map.
+    */
+    class iterator
+    {
+    public:
+        iterator();
+
+        std::pair<const Key, Value>& operator*() const;
+        std::pair<const Key, Value>* operator->() const;
+
+        bool operator==(const iterator& rhs) const;
+        bool operator!=(const iterator& rhs) const;
+
+        iterator& operator++();
+
+    protected:
+        friend class ShardedAVLTree<Key, Value>;
+
+        void skipEmpty();
+
+        const ShardedAVLTree<Key, Value>* owner_;
+        size_t shard_;
+        ShardIterator current_;
+    };
+
+    iterator begin() const;
+    iterator end() const;
+
+protected:
+    Shard& lockShard(const Key& key, std::unique_lock<std::mutex>& guard) const;
+    bool moveBound(size_t hot, size_t cold);
+
+private:
+    // shards hold locks and are pointed into by routing tables
+    ShardedAVLTree(const ShardedAVLTree&);
+    ShardedAVLTree& operator=(const ShardedAVLTree&);
+
+protected:
+    std::vector<std::unique_ptr<Shard> > shards_;
+    std::atomic<const Routing*> routing_;
+    std::vector<std::unique_ptr<Routing> > tables_;     // every table published
+    std::mutex rebalanceLock_;
+};
+
+/*
+--------------------------------------------------------------
+Begin implementations for the ShardedAVLTree::iterator class.
+---------------------------------------------------------------
+*/
+
+template<class Key, class Value>
+ShardedAVLTree<Key, Value>::iterator::iterator() :
+    owner_(nullptr), shard_(0)
+{
+
+}
+
+template<class Key, class Value>
+std::pair<const Key, Value>& ShardedAVLTree<Key, Value>::iterator::operator*() const
+{
+    return *current_;
+}
+
+template<class Key, class Value>
+std::pair<const Key, Value>* ShardedAVLTree<Key, Value>::iterator::operator->() const
+{
+    return &(*current_);
+}
+
+/**
+* Shard iterators at end() are all equal, so end() needs no shard.
+*/
+template<class Key, class Value>
+bool ShardedAVLTree<Key, Value>::iterator::operator==(const iterator& rhs) const
+{
+    return current_ == rhs.current_;
+}
+
+template<class Key, class Value>
+bool ShardedAVLTree<Key, Value>::iterator::operator!=(const iterator& rhs) const
+{
+    return current_ != rhs.current_;
+}
+
+/**
+* Moves past the end of the current shard into the next non-empty one.
+*/
+template<class Key, class Value>
+void ShardedAVLTree<Key, Value>::iterator::skipEmpty()
+{
+    while (current_ == ShardIterator() && shard_ + 1 < owner_->shards_.size()){
+      shard_++;
+      current_ = owner_->shards_[shard_]->tree.begin();
+    }
+}
+
+template<class Key, class Value>
+typename ShardedAVLTree<Key, Value>::iterator& ShardedAVLTree<Key, Value>::iterator::operator++()
+{
+    ++current_;
+    skipEmpty();
+    return *this;
+}
+
+/*
+-------------------------------------------------------------
+End implementations for the ShardedAVLTree::iterator class.
+-------------------------------------------------------------
+*/
+
+/*
+-----------------------------------------------------
+Begin implementations for the ShardedAVLTree class.
+-----------------------------------------------------
+*/
+
+/**
+* Makes bounds.size() + 1 shards split at the given keys. Throws
+* std::invalid_argument unless the bounds are strictly increasing.
+*/
+template<class Key, class Value>
+ShardedAVLTree<Key, Value>::ShardedAVLTree(const std::vector<Key>& bounds)
+{
+    for (size_t i = 1; i < bounds.size(); i++){
+      if (!(bounds[i - 1] < bounds[i])){
+        throw std::invalid_argument("Bounds not strictly increasing");
+      }
+    }
+    tables_.push_back(std::unique_ptr<Routing>(new Routing));
+    Routing* table = tables_.back().get();
+    table->bounds = bounds;
+    for (size_t i = 0; i <= bounds.size(); i++){
+      shards_.push_back(std::unique_ptr<Shard>(new Shard));
+      shards_[i]->lo = i == 0 ? nullptr : &table->bounds[i - 1];
+      shards_[i]->hi = i == bounds.size() ? nullptr : &table->bounds[i];
+    }
+    routing_.store(table, std::memory_order_release);
+}
+
+/**
+* Locks and returns the shard that owns key. The routing table may be
+* replaced between reading it and taking the lock, so the choice is checked
+* against the shard's own bounds once locked, and retried if it is stale.
+*/
+template<class Key, class Value>
+typename ShardedAVLTree<Key, Value>::Shard&
+ShardedAVLTree<Key, Value>::lockShard(const Key& key, std::unique_lock<std::mutex>& guard) const
+{
+    while (true){
+      const Routing* table = routing_.load(std::memory_order_acquire);
+      //keys equal to a bound belong to the shard above it
+      size_t i = std::upper_bound(table->bounds.begin(), table->bounds.end(), key) - table->bounds.begin();
+      Shard& shard = *shards_[i];
+      std::unique_lock<std::mutex> attempt(shard.lock);
+      if (shard.owns(key)){
+        guard.swap(attempt);
+        return shard;
+      }
+    }
+}
+
+/**
+* If key is already in the map, the current value is overwritten
+* with the updated value.
+*/
+template<class Key, class Value>
+void ShardedAVLTree<Key, Value>::insert(const std::pair<const Key, Value>& keyValuePair)
+{
+    std::unique_lock<std::mutex> guard;
+    Shard& shard = lockShard(keyValuePair.first, guard);
+    shard.tree.insert(keyValuePair);
+    shard.writes++;
+}
+
+template<class Key, class Value>
+void ShardedAVLTree<Key, Value>::remove(const Key& key)
+{
+    std::unique_lock<std::mutex> guard;
+    Shard& shard = lockShard(key, guard);
+    shard.tree.remove(key);
+    shard.writes++;
+}
+
+/**
+* Copies key's value into value and returns true, or returns false if key
+* is not in the map.
+*/
+template<class Key, class Value>
+bool ShardedAVLTree<Key, Value>::find(const Key& key, Value& value) const
+{
+    std::unique_lock<std::mutex> guard;
+    Shard& shard = lockShard(key, guard);
+    ShardIterator it = shard.tree.find(key);
+    if (it == shard.tree.end()){
+      return false;
+    }
+    value = it->second;
+    return true;
+}
+
+template<class Key, class Value>
+bool ShardedAVLTree<Key, Value>::contains(const Key& key) const
+{
+    std::unique_lock<std::mutex> guard;
+    Shard& shard = lockShard(key, guard);
+    return shard.tree.find(key) != shard.tree.end();
+}
+
+/**
+ * @precondition The key exists in the map
+ * Returns the value associated with the key
+ */
+template<class Key, class Value>
+Value ShardedAVLTree<Key, Value>::operator[](const Key& key) const
+{
+    std::unique_lock<std::mutex> guard;
+    Shard& shard = lockShard(key, guard);
+    ShardIterator it = shard.tree.find(key);
+    if(it == shard.tree.end()) throw std::out_of_range("Invalid key");
+    return it->second;
+}
+
+/**
+* Empties every shard, one at a time. The bounds stay where they are.
+*/
+template<class Key, class Value>
+void ShardedAVLTree<Key, Value>::clear()
+{
+    for (size_t i = 0; i < shards_.size(); i++){
+      std::lock_guard<std::mutex> guard(shards_[i]->lock);
+      shards_[i]->tree.clear();
+      shards_[i]->writes = 0;
+    }
+}
+
+template<class Key, class Value>
+bool ShardedAVLTree<Key, Value>::empty() const
+{
+    return size() == 0;
+}
+
+/**
+* The sum of the shard sizes, each read under its lock, so only exact
+* while no other thread is writing.
+*/
+template<class Key, class Value>
+size_t ShardedAVLTree<Key, Value>::size() const
+{
+    size_t total = 0;
+    for (size_t i = 0; i < shards_.size(); i++){
+      total += shardSize(i);
+    }
+    return total;
+}
+
+template<class Key, class Value>
+size_t ShardedAVLTree<Key, Value>::shardCount() const
+{
+    return shards_.size();
+}
+
+template<class Key, class Value>
+size_t ShardedAVLTree<Key, Value>::shardSize(size_t shard) const
+{
+    std::lock_guard<std::mutex> guard(shards_[shard]->lock);
+    return shards_[shard]->tree.size();
+}
+
+/**
+* Calls fn(item) on every item in key order. Each shard is locked while it
+* is visited, and the next shard is locked before the previous one is let
+* go, so a concurrent rebalance can never move an item past the walk: every
+* item present throughout is visited exactly once. fn must not call back
+* into the map.
+*/
+template<class Key, class Value>
+template<typename Fn>
+void ShardedAVLTree<Key, Value>::forEach(Fn fn) const
+{
+    std::unique_lock<std::mutex> held(shards_[0]->lock);
+    for (size_t i = 0; i < shards_.size(); i++){
+      const ShardTree& tree = shards_[i]->tree;
+      for (ShardIterator it = tree.begin(); it != tree.end(); ++it){
+        fn(*it);
+      }
+      if (i + 1 < shards_.size()){
+        std::unique_lock<std::mutex> next(shards_[i + 1]->lock);
+        held.swap(next);
+      }
+    }
+}
+
+/**
+* Finds the shard with the most writes since the last rebalance and, if
+* it has at least skew times the average, moves the bound between it and
+* its neighbour with fewer writes so that half of its items go to the
+* neighbour. Write counts start over either way. Returns true if a bound
+* moved. Other operations carry on meanwhile, except on the two shards
+* involved while their items move.
+*/
+template<class Key, class Value>
+bool ShardedAVLTree<Key, Value>::rebalance(double skew)
+{
+    std::lock_guard<std::mutex> only(rebalanceLock_);
+    size_t count = shards_.size();
+    std::vector<uint64_t> writes(count);
+    uint64_t total = 0;
+    for (size_t i = 0; i < count; i++){
+      std::lock_guard<std::mutex> guard(shards_[i]->lock);
+      writes[i] = shards_[i]->writes;
+      shards_[i]->writes = 0;
+      total += writes[i];
+    }
+    if (count < 2 || total == 0){
+      return false;
+    }
+
+    size_t hot = std::max_element(writes.begin(), writes.end()) - writes.begin();
+    if ((double)writes[hot] < skew * (double)total / (double)count){
+      return false;
+    }
+    size_t cold;
+    if (hot == 0){
+      cold = 1;
+    }
+    else if (hot + 1 == count){
+      cold = hot - 1;
+    }
+    else {
+      cold = writes[hot - 1] <= writes[hot + 1] ? hot - 1 : hot + 1;
+    }
+    return moveBound(hot, cold);
+}
+
+/**
+* Moves the half of hot's items nearest cold (an adjacent shard) into
+* cold, with both locked in index order, and publishes a routing table
+* with the new bound. Items leave hot from its end with popMin/popMax and
+* join cold at its end with a hinted insert, so each move is amortized
+* O(1) apart from the removal's rebalancing. Returns false if hot has too
+* few items to split.
+*/
+template<class Key, class Value>
+bool ShardedAVLTree<Key, Value>::moveBound(size_t hot, size_t cold)
+{
+    Shard& low = *shards_[std::min(hot, cold)];
+    Shard& high = *shards_[std::max(hot, cold)];
+    std::lock_guard<std::mutex> lowGuard(low.lock);
+    std::lock_guard<std::mutex> highGuard(high.lock);
+
+    ShardTree& from = shards_[hot]->tree;
+    ShardTree& to = shards_[cold]->tree;
+    size_t moving = from.size() / 2;
+    if (moving == 0){
+      return false;
+    }
+    const Routing* current = routing_.load(std::memory_order_relaxed);
+    tables_.push_back(std::unique_ptr<Routing>(new Routing(*current)));
+    Routing* table = tables_.back().get();
+    size_t bound = std::min(hot, cold);
+
+    if (cold < hot){
+      for (size_t i = 0; i < moving; i++){
+        to.insert(to.end(), from.popMin());
+      }
+      //hot's new smallest key is the first it keeps
+      table->bounds[bound] = from.min().first;
+    }
+    else {
+      for (size_t i = 0; i < moving; i++){
+        to.insert(to.begin(), from.popMax());
+      }
+      table->bounds[bound] = to.min().first;
+    }
+    low.hi = &table->bounds[bound];
+    high.lo = &table->bounds[bound];
+    routing_.store(table, std::memory_order_release);
+    return true;
+}
+
+template<class Key, class Value>
+typename ShardedAVLTree<Key, Value>::iterator ShardedAVLTree<Key, Value>::begin() const
+{
+    iterator it;
+    it.owner_ = this;
+    it.current_ = shards_[0]->tree.begin();
+    it.skipEmpty();
+    return it;
+}
+
+template<class Key, class Value>
+typename ShardedAVLTree<Key, Value>::iterator ShardedAVLTree<Key, Value>::end() const
+{
+    return iterator();
+}
+
+/*
+---------------------------------------------------
+End implementations for the ShardedAVLTree class.
+---------------------------------------------------
+*/
+
+#endif
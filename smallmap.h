@@ -0,0 +1,368 @@
+#ifndef SMALLMAP_H
+#define SMALLMAP_H
+
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <vector>
+#include <type_traits>
+#include "avlbst.h"
+
+/**
+* An ordered map for the common case of a handful of entries. Up to N items
+* live inline in the map object as a sorted array, so a small map makes no
+* heap allocations at all; the insert that would make it N + 1 items moves
+* everything into an AVLTree with one linear buildSorted, and from then on
+* every operation goes to the tree. The map goes back to inline mode when
+* it is cleared or the tree is emptied, but not merely because it shrank,
+* so a map hovering around N does not convert back and forth.
+*
+* The inline search is a branch-free count of the keys below the one
+* sought, which compilers vectorize for integral keys and which beats a
+* binary search at these sizes.
+*
+* Iterators have the same interface as BinarySearchTree's, and like them are
+* invalidated by removing the item they point to. Inserting into an inline
+* map shifts items, so it invalidates every iterator, as does the promotion.
+*/
+template <class Key, class Value, size_t N = 16>
+class SmallAVLMap
+{
+public:
+    typedef std::pair<const Key, Value> Item;
+
+    SmallAVLMap();
+    ~SmallAVLMap();
+
+    void insert(const Item& keyValuePair);
+    void remove(const Key& key);
+    void clear();
+    bool empty() const;
+    // true while the items are stored in the object itself
+    bool isInline() const;
+
+    /**
+    * An iterator over either representation: a slot pointer while the map
+    * is inline, a tree iterator once it is not. Both are null at end().
+    */
+    class iterator
+    {
+    public:
+        iterator();
+
+        Item& operator*() const;
+        Item* operator->() const;
+
+        bool operator==(const iterator& rhs) const;
+        bool operator!=(const iterator& rhs) const;
+
+        iterator& operator++();
+
+    protected:
+        friend class SmallAVLMap<Key, Value, N>;
+
+        Item* slot_;
+        Item* slotEnd_;
+        typename AVLTree<Key, Value>::iterator treeIt_;
+    };
+
+    iterator begin() const;
+    iterator end() const;
+    iterator find(const Key& key) const;
+    Value& operator[](const Key& key);
+    Value const & operator[](const Key& key) const;
+
+protected:
+    Item* slot(size_t i) const;
+    size_t lowerIndex(const Key& key) const;
+    void destroySlots();
+    void promote(size_t pos, const Item& keyValuePair);
+
+private:
+    // the slots hold raw storage that a memberwise copy would not copy
+    SmallAVLMap(const SmallAVLMap&);
+    SmallAVLMap& operator=(const SmallAVLMap&);
+
+protected:
+    typename std::aligned_storage<sizeof(Item), std::alignment_of<Item>::value>::type slots_[N];
+    size_t count_;      // items in slots_, 0 once promoted
+    bool inline_;
+    AVLTree<Key, Value> tree_;
+};
+
+/*
+--------------------------------------------------------------
+Begin implementations for the SmallAVLMap::iterator class.
+---------------------------------------------------------------
+*/
+
+template<class Key, class Value, size_t N>
+SmallAVLMap<Key, Value, N>::iterator::iterator() :
+    slot_(nullptr), slotEnd_(nullptr)
+{
+
+}
+
+template<class Key, class Value, size_t N>
+typename SmallAVLMap<Key, Value, N>::Item&
+SmallAVLMap<Key, Value, N>::iterator::operator*() const
+{
+    return slot_ != nullptr ? *slot_ : *treeIt_;
+}
+
+template<class Key, class Value, size_t N>
+typename SmallAVLMap<Key, Value, N>::Item*
+SmallAVLMap<Key, Value, N>::iterator::operator->() const
+{
+    return &(**this);
+}
+
+template<class Key, class Value, size_t N>
+bool SmallAVLMap<Key, Value, N>::iterator::operator==(const iterator& rhs) const
+{
+    return slot_ == rhs.slot_ && treeIt_ == rhs.treeIt_;
+}
+
+template<class Key, class Value, size_t N>
+bool SmallAVLMap<Key, Value, N>::iterator::operator!=(const iterator& rhs) const
+{
+    return !(*this == rhs);
+}
+
+template<class Key, class Value, size_t N>
+typename SmallAVLMap<Key, Value, N>::iterator&
+SmallAVLMap<Key, Value, N>::iterator::operator++()
+{
+    if (slot_ != nullptr){
+      ++slot_;
+      if (slot_ == slotEnd_){
+        slot_ = nullptr;
+        slotEnd_ = nullptr;
+      }
+    }
+    else {
+      ++treeIt_;
+    }
+    return *this;
+}
+
+/*
+-------------------------------------------------------------
+End implementations for the SmallAVLMap::iterator class.
+-------------------------------------------------------------
+*/
+
+/*
+-----------------------------------------------------
+Begin implementations for the SmallAVLMap class.
+-----------------------------------------------------
+*/
+
+template<class Key, class Value, size_t N>
+SmallAVLMap<Key, Value, N>::SmallAVLMap() :
+    count_(0), inline_(true)
+{
+
+}
+
+template<class Key, class Value, size_t N>
+SmallAVLMap<Key, Value, N>::~SmallAVLMap()
+{
+    destroySlots();
+}
+
+template<class Key, class Value, size_t N>
+typename SmallAVLMap<Key, Value, N>::Item* SmallAVLMap<Key, Value, N>::slot(size_t i) const
+{
+    return reinterpret_cast<Item*>(const_cast<typename std::aligned_storage<sizeof(Item),
+        std::alignment_of<Item>::value>::type*>(&slots_[i]));
+}
+
+/**
+* The number of inline keys less than key, which is where key is or
+* would go.
+*/
+template<class Key, class Value, size_t N>
+size_t SmallAVLMap<Key, Value, N>::lowerIndex(const Key& key) const
+{
+    size_t below = 0;
+    for (size_t i = 0; i < count_; i++){
+      below += slot(i)->first < key;
+    }
+    return below;
+}
+
+template<class Key, class Value, size_t N>
+void SmallAVLMap<Key, Value, N>::destroySlots()
+{
+    for (size_t i = 0; i < count_; i++){
+      slot(i)->~Item();
+    }
+    count_ = 0;
+}
+
+template<class Key, class Value, size_t N>
+bool SmallAVLMap<Key, Value, N>::empty() const
+{
+    return inline_ ? count_ == 0 : tree_.empty();
+}
+
+template<class Key, class Value, size_t N>
+bool SmallAVLMap<Key, Value, N>::isInline() const
+{
+    return inline_;
+}
+
+template<class Key, class Value, size_t N>
+void SmallAVLMap<Key, Value, N>::clear()
+{
+    destroySlots();
+    tree_.clear();
+    inline_ = true;
+}
+
+/**
+* If key is already in the map, the current value is overwritten
+* with the updated value.
+*/
+template<class Key, class Value, size_t N>
+void SmallAVLMap<Key, Value, N>::insert(const Item& keyValuePair)
+{
+    if (!inline_){
+      tree_.insert(keyValuePair);
+      return;
+    }
+    size_t pos = lowerIndex(keyValuePair.first);
+    if (pos < count_ && !(keyValuePair.first < slot(pos)->first)){
+      slot(pos)->second = keyValuePair.second;
+      return;
+    }
+    if (count_ == N){
+      promote(pos, keyValuePair);
+      return;
+    }
+
+    //open a gap at pos; keys are const, so items move by reconstruction
+    for (size_t i = count_; i > pos; i--){
+      new (slot(i)) Item(std::move(*slot(i - 1)));
+      slot(i - 1)->~Item();
+    }
+    new (slot(pos)) Item(keyValuePair);
+    count_++;
+}
+
+/**
+* Moves the N inline items plus the new one (which belongs at pos) into
+* the tree.
+*/
+template<class Key, class Value, size_t N>
+void SmallAVLMap<Key, Value, N>::promote(size_t pos, const Item& keyValuePair)
+{
+    std::vector<Item> items;
+    items.reserve(N + 1);
+    for (size_t i = 0; i < count_; i++){
+      if (i == pos){
+        items.push_back(keyValuePair);
+      }
+      items.push_back(std::move(*slot(i)));
+    }
+    if (pos == count_){
+      items.push_back(keyValuePair);
+    }
+    tree_.buildSorted(&items[0], items.size());
+    destroySlots();
+    inline_ = false;
+}
+
+template<class Key, class Value, size_t N>
+void SmallAVLMap<Key, Value, N>::remove(const Key& key)
+{
+    if (!inline_){
+      tree_.remove(key);
+      if (tree_.empty()){
+        inline_ = true;
+      }
+      return;
+    }
+    size_t pos = lowerIndex(key);
+    if (pos == count_ || key < slot(pos)->first){
+      //nothing to remove
+      return;
+    }
+    slot(pos)->~Item();
+    for (size_t i = pos + 1; i < count_; i++){
+      new (slot(i - 1)) Item(std::move(*slot(i)));
+      slot(i)->~Item();
+    }
+    count_--;
+}
+
+template<class Key, class Value, size_t N>
+typename SmallAVLMap<Key, Value, N>::iterator
+SmallAVLMap<Key, Value, N>::begin() const
+{
+    iterator it;
+    if (!inline_){
+      it.treeIt_ = tree_.begin();
+    }
+    else if (count_ > 0){
+      it.slot_ = slot(0);
+      it.slotEnd_ = slot(0) + count_;
+    }
+    return it;
+}
+
+template<class Key, class Value, size_t N>
+typename SmallAVLMap<Key, Value, N>::iterator
+SmallAVLMap<Key, Value, N>::end() const
+{
+    return iterator();
+}
+
+template<class Key, class Value, size_t N>
+typename SmallAVLMap<Key, Value, N>::iterator
+SmallAVLMap<Key, Value, N>::find(const Key& key) const
+{
+    iterator it;
+    if (!inline_){
+      it.treeIt_ = tree_.find(key);
+      return it;
+    }
+    size_t pos = lowerIndex(key);
+    if (pos < count_ && !(key < slot(pos)->first)){
+      it.slot_ = slot(pos);
+      it.slotEnd_ = slot(0) + count_;
+    }
+    return it;
+}
+
+/**
+ * @precondition The key exists in the map
+ * Returns the value associated with the key
+ */
+template<class Key, class Value, size_t N>
+Value& SmallAVLMap<Key, Value, N>::operator[](const Key& key)
+{
+    iterator it = find(key);
+    if(it == end()) throw std::out_of_range("Invalid key");
+    return it->second;
+}
+
+template<class Key, class Value, size_t N>
+Value const & SmallAVLMap<Key, Value, N>::operator[](const Key& key) const
+{
+    iterator it = find(key);
+    if(it == end()) throw std::out_of_range("Invalid key");
+    return it->second;
+}
+
+/*
+---------------------------------------------------
+End implementations for the SmallAVLMap class.
+---------------------------------------------------
+*/
+
+#endif
@@ -0,0 +1,275 @@
+#ifndef STRINGAVL_H
+#define STRINGAVL_H
+
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdint>
+#include <string>
+#include "avlbst.h"
+
+/**
+* An AVL node for std::string keys that also keeps the key's first 8 bytes
+* packed big-endian into an integer (zero-padded for shorter keys).
+* Comparing two prefixes as integers orders them exactly as std::string
+* orders the bytes, so unequal prefixes decide a comparison without
+* touching the string's heap buffer.
+*/
+template <typename Value>
+class PrefixAVLNode : public AVLNode<std::string, Value>
+{
+public:
+    PrefixAVLNode(const std::string& key, const Value& value);
+    virtual ~PrefixAVLNode();
+
+    uint64_t getPrefix() const;
+
+    static uint64_t prefixOf(const std::string& key);
+
+protected:
+    uint64_t prefix_;
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the PrefixAVLNode class.
+  -------------------------------------------------
+*/
+
+template<class Value>
+PrefixAVLNode<Value>::PrefixAVLNode(const std::string& key, const Value& value) :
+    AVLNode<std::string, Value>(key, value, nullptr), prefix_(prefixOf(key))
+{
+
+}
+
+template<class Value>
+PrefixAVLNode<Value>::~PrefixAVLNode()
+{
+
+}
+
+template<class Value>
+uint64_t PrefixAVLNode<Value>::getPrefix() const
+{
+    return prefix_;
+}
+
+/**
+* std::string compares bytes as unsigned char, so the first byte goes in
+* the top 8 bits. A key shorter than 8 bytes is padded with zeros, which
+* can only tie with a longer key whose next bytes are also zero; ties fall
+* back to the full comparison.
+*/
+template<class Value>
+uint64_t PrefixAVLNode<Value>::prefixOf(const std::string& key)
+{
+    uint64_t prefix = 0;
+    size_t length = key.size() < 8 ? key.size() : 8;
+    for (size_t i = 0; i < length; i++){
+      prefix |= (uint64_t)(unsigned char)key[i] << (56 - 8 * i);
+    }
+    return prefix;
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the PrefixAVLNode class.
+  -----------------------------------------------
+*/
+
+/**
+* An AVLTree keyed on std::string whose descents compare cached 8-byte
+* prefixes first (see PrefixAVLNode), so a lookup reads each node once
+* instead of once for the node and again for the key's heap buffer. Only
+* keys sharing their first 8 bytes with the one sought compare in full.
+*
+* find, operator[], contains, insert and remove use the prefix descent.
+* Everything else is AVLTree's and still correct, just without the
+* shortcut. Strings of up to 15 bytes are stored inside std::string itself
+* on common standard libraries, so the saving is for longer keys.
+*/
+template <class Value>
+class StringAVLTree : public AVLTree<std::string, Value>
+{
+public:
+    typedef typename AVLTree<std::string, Value>::iterator iterator;
+
+    StringAVLTree();
+    StringAVLTree(StringAVLTree&& other) noexcept;
+    StringAVLTree& operator=(StringAVLTree&& other) noexcept;
+    void swap(StringAVLTree& other) noexcept;
+    virtual void insert(const std::pair<const std::string, Value>& new_item);
+    using AVLTree<std::string, Value>::insert;
+    virtual void remove(const std::string& key);
+    iterator find(const std::string& key) const;
+    bool contains(const std::string& key) const;
+    Value& operator[](const std::string& key);
+    Value const & operator[](const std::string& key) const;
+    StringAVLTree clone() const;
+
+protected:
+    virtual AVLNode<std::string, Value>* createNode(const std::string& key, const Value& value);
+    virtual size_t nodeBytes() const;
+
+    static int compareTo(const std::string& key, uint64_t prefix, const Node<std::string, Value>* node);
+    Node<std::string, Value>* prefixFind(const std::string& key) const;
+};
+
+template<class Value>
+StringAVLTree<Value>::StringAVLTree()
+{
+
+}
+
+/**
+* Each node keeps its own prefix, so nodes move as they are.
+*/
+template<class Value>
+StringAVLTree<Value>::StringAVLTree(StringAVLTree&& other) noexcept :
+    AVLTree<std::string, Value>(static_cast<AVLTree<std::string, Value>&&>(other))
+{
+
+}
+
+template<class Value>
+StringAVLTree<Value>& StringAVLTree<Value>::operator=(StringAVLTree&& other) noexcept
+{
+    StringAVLTree<Value> old(std::move(other));
+    swap(old);
+    return *this;
+}
+
+template<class Value>
+void StringAVLTree<Value>::swap(StringAVLTree& other) noexcept
+{
+    AVLTree<std::string, Value>::swap(static_cast<AVLTree<std::string, Value>&>(other));
+}
+
+/**
+* createNode recomputes each copy's prefix from its key.
+*/
+template<class Value>
+StringAVLTree<Value> StringAVLTree<Value>::clone() const
+{
+    StringAVLTree<Value> copy;
+    copy.cloneFrom(*this);
+    return copy;
+}
+
+template<class Value>
+AVLNode<std::string, Value>* StringAVLTree<Value>::createNode(const std::string& key, const Value& value)
+{
+    return new PrefixAVLNode<Value>(key, value);
+}
+
+template<class Value>
+size_t StringAVLTree<Value>::nodeBytes() const
+{
+    return sizeof(PrefixAVLNode<Value>);
+}
+
+/**
+* Compares key (whose prefix is given) with node's key, with the same
+* sign convention as std::string::compare.
+*/
+template<class Value>
+int StringAVLTree<Value>::compareTo(const std::string& key, uint64_t prefix, const Node<std::string, Value>* node)
+{
+    uint64_t nodePrefix = static_cast<const PrefixAVLNode<Value>*>(node)->getPrefix();
+    if (prefix != nodePrefix){
+      return prefix < nodePrefix ? -1 : 1;
+    }
+    return key.compare(node->getKey());
+}
+
+template<class Value>
+Node<std::string, Value>* StringAVLTree<Value>::prefixFind(const std::string& key) const
+{
+    uint64_t prefix = PrefixAVLNode<Value>::prefixOf(key);
+    Node<std::string, Value>* curr = this->root_;
+    while (curr != nullptr){
+      int cmp = compareTo(key, prefix, curr);
+      if (cmp == 0){
+        return curr;
+      }
+      curr = cmp < 0 ? curr->getLeft() : curr->getRight();
+    }
+    return nullptr;
+}
+
+/**
+* Same as AVLTree::insert, descending by prefix.
+*/
+template<class Value>
+void StringAVLTree<Value>::insert(const std::pair<const std::string, Value>& new_item)
+{
+    uint64_t prefix = PrefixAVLNode<Value>::prefixOf(new_item.first);
+    Node<std::string, Value>* prev = nullptr;
+    Node<std::string, Value>* curr = this->root_;
+    while (curr != nullptr){
+      int cmp = compareTo(new_item.first, prefix, curr);
+      if (cmp == 0){ //same key, so rewrite value
+        curr->setValue(new_item.second);
+        this->nodeUpdated(curr);
+        return;
+      }
+      prev = curr;
+      curr = cmp < 0 ? curr->getLeft() : curr->getRight();
+    }
+
+    AVLNode<std::string, Value>* node = createNode(new_item.first, new_item.second);
+    if (prev == nullptr){
+      this->root_ = node;
+      this->nodeLinked(node);
+      this->finger_ = node;
+      return;
+    }
+    this->linkNode(static_cast<AVLNode<std::string, Value>*>(prev), node);
+}
+
+template<class Value>
+void StringAVLTree<Value>::remove(const std::string& key)
+{
+    Node<std::string, Value>* node = prefixFind(key);
+    if (node == nullptr){
+      //nothing to remove
+      return;
+    }
+    this->removeNode(node);
+}
+
+template<class Value>
+typename StringAVLTree<Value>::iterator StringAVLTree<Value>::find(const std::string& key) const
+{
+    return this->makeIterator(prefixFind(key));
+}
+
+template<class Value>
+bool StringAVLTree<Value>::contains(const std::string& key) const
+{
+    return prefixFind(key) != nullptr;
+}
+
+/**
+ * @precondition The key exists in the map
+ * Returns the value associated with the key
+ */
+template<class Value>
+Value& StringAVLTree<Value>::operator[](const std::string& key)
+{
+    Node<std::string, Value>* curr = prefixFind(key);
+    if(curr == nullptr) throw std::out_of_range("Invalid key");
+    return curr->getValue();
+}
+
+template<class Value>
+Value const & StringAVLTree<Value>::operator[](const std::string& key) const
+{
+    Node<std::string, Value>* curr = prefixFind(key);
+    if(curr == nullptr) throw std::out_of_range("Invalid key");
+    return curr->getValue();
+}
+
+#endif
@@ -0,0 +1,229 @@
+#ifndef THREADEDAVL_H
+#define THREADEDAVL_H
+
+#include <iostream>
+#include <exception>
+#include <cstdlib>
+#include "avlbst.h"
+
+/**
+* An AVL node that also keeps direct links to its in-order neighbours, so
+* stepping an iterator is a single pointer load instead of a walk up the
+* parent chain. Costs two extra pointers per node.
+*/
+template <typename Key, typename Value>
+class ThreadedAVLNode : public AVLNode<Key, Value>
+{
+public:
+    ThreadedAVLNode(const Key& key, const Value& value);
+    virtual ~ThreadedAVLNode();
+
+    virtual Node<Key, Value>* getSuccessor() const override;
+    virtual Node<Key, Value>* getPredecessor() const override;
+
+    ThreadedAVLNode<Key, Value>* getNext() const;
+    ThreadedAVLNode<Key, Value>* getPrev() const;
+    void setNext(ThreadedAVLNode<Key, Value>* next);
+    void setPrev(ThreadedAVLNode<Key, Value>* prev);
+
+protected:
+    ThreadedAVLNode<Key, Value>* next_;
+    ThreadedAVLNode<Key, Value>* prev_;
+};
+
+/*
+  -------------------------------------------------
+  Begin implementations for the ThreadedAVLNode class.
+  -------------------------------------------------
+*/
+
+template<class Key, class Value>
+ThreadedAVLNode<Key, Value>::ThreadedAVLNode(const Key& key, const Value& value) :
+    AVLNode<Key, Value>(key, value, nullptr), next_(nullptr), prev_(nullptr)
+{
+
+}
+
+template<class Key, class Value>
+ThreadedAVLNode<Key, Value>::~ThreadedAVLNode()
+{
+
+}
+
+/**
+* The successor is the stored link; no tree walk.
+*/
+template<class Key, class Value>
+Node<Key, Value>* ThreadedAVLNode<Key, Value>::getSuccessor() const
+{
+    return next_;
+}
+
+template<class Key, class Value>
+Node<Key, Value>* ThreadedAVLNode<Key, Value>::getPredecessor() const
+{
+    return prev_;
+}
+
+template<class Key, class Value>
+ThreadedAVLNode<Key, Value>* ThreadedAVLNode<Key, Value>::getNext() const
+{
+    return next_;
+}
+
+template<class Key, class Value>
+ThreadedAVLNode<Key, Value>* ThreadedAVLNode<Key, Value>::getPrev() const
+{
+    return prev_;
+}
+
+template<class Key, class Value>
+void ThreadedAVLNode<Key, Value>::setNext(ThreadedAVLNode<Key, Value>* next)
+{
+    next_ = next;
+}
+
+template<class Key, class Value>
+void ThreadedAVLNode<Key, Value>::setPrev(ThreadedAVLNode<Key, Value>* prev)
+{
+    prev_ = prev;
+}
+
+/*
+  -----------------------------------------------
+  End implementations for the ThreadedAVLNode class.
+  -----------------------------------------------
+*/
+
+/**
+* An AVLTree whose nodes form a doubly linked list in key order. Rotations
+* never change the in-order sequence, so the list only needs updating when
+* a node is linked in or unlinked, through the nodeLinked/nodeUnlinking
+* hooks. Full scans then run at linked-list speed.
+*/
+template <class Key, class Value>
+class ThreadedAVLTree : public AVLTree<Key, Value>
+{
+public:
+    ThreadedAVLTree();
+    ThreadedAVLTree(ThreadedAVLTree&& other) noexcept;
+    ThreadedAVLTree& operator=(ThreadedAVLTree&& other) noexcept;
+    void swap(ThreadedAVLTree& other) noexcept;
+    ThreadedAVLTree clone() const;
+
+protected:
+    virtual AVLNode<Key, Value>* createNode(const Key& key, const Value& value);
+    virtual size_t nodeBytes() const;
+    virtual void nodeLinked(Node<Key, Value>* n);
+    virtual void nodeUnlinking(Node<Key, Value>* n);
+};
+
+template<class Key, class Value>
+ThreadedAVLTree<Key, Value>::ThreadedAVLTree()
+{
+
+}
+
+/**
+* The list runs through the nodes, so it moves with them.
+*/
+template<class Key, class Value>
+ThreadedAVLTree<Key, Value>::ThreadedAVLTree(ThreadedAVLTree&& other) noexcept :
+    AVLTree<Key, Value>(static_cast<AVLTree<Key, Value>&&>(other))
+{
+
+}
+
+template<class Key, class Value>
+ThreadedAVLTree<Key, Value>& ThreadedAVLTree<Key, Value>::operator=(ThreadedAVLTree&& other) noexcept
+{
+    ThreadedAVLTree<Key, Value> old(std::move(other));
+    swap(old);
+    return *this;
+}
+
+template<class Key, class Value>
+void ThreadedAVLTree<Key, Value>::swap(ThreadedAVLTree& other) noexcept
+{
+    AVLTree<Key, Value>::swap(static_cast<AVLTree<Key, Value>&>(other));
+}
+
+/**
+* The copy's nodes are linked in pre-order through nodeLinked, which
+* threads each one in as it goes.
+*/
+template<class Key, class Value>
+ThreadedAVLTree<Key, Value> ThreadedAVLTree<Key, Value>::clone() const
+{
+    ThreadedAVLTree<Key, Value> copy;
+    copy.cloneFrom(*this);
+    return copy;
+}
+
+template<class Key, class Value>
+AVLNode<Key, Value>* ThreadedAVLTree<Key, Value>::createNode(const Key& key, const Value& value)
+{
+    return new ThreadedAVLNode<Key, Value>(key, value);
+}
+
+template<class Key, class Value>
+size_t ThreadedAVLTree<Key, Value>::nodeBytes() const
+{
+    return sizeof(ThreadedAVLNode<Key, Value>);
+}
+
+/**
+* A new leaf's neighbours are its parent and the parent's old neighbour on
+* the same side.
+*/
+template<class Key, class Value>
+void ThreadedAVLTree<Key, Value>::nodeLinked(Node<Key, Value>* n)
+{
+    AVLTree<Key, Value>::nodeLinked(n);
+
+    ThreadedAVLNode<Key, Value>* node = static_cast<ThreadedAVLNode<Key, Value>*>(n);
+    ThreadedAVLNode<Key, Value>* parent = static_cast<ThreadedAVLNode<Key, Value>*>(n->getParent());
+    if (parent == nullptr){
+      return;
+    }
+
+    ThreadedAVLNode<Key, Value>* prev;
+    ThreadedAVLNode<Key, Value>* next;
+    if (parent->getLeft() == n){
+      prev = parent->getPrev();
+      next = parent;
+    }
+    else {
+      prev = parent;
+      next = parent->getNext();
+    }
+    node->setPrev(prev);
+    node->setNext(next);
+    if (prev != nullptr){
+      prev->setNext(node);
+    }
+    if (next != nullptr){
+      next->setPrev(node);
+    }
+}
+
+/**
+* Splices the node out of the list. By the time this runs a 2-child node
+* has already been swapped with its predecessor, which is its neighbour in
+* the list either way, so the remaining links stay in key order.
+*/
+template<class Key, class Value>
+void ThreadedAVLTree<Key, Value>::nodeUnlinking(Node<Key, Value>* n)
+{
+    AVLTree<Key, Value>::nodeUnlinking(n);
+
+    ThreadedAVLNode<Key, Value>* node = static_cast<ThreadedAVLNode<Key, Value>*>(n);
+    if (node->getPrev() != nullptr){
+      node->getPrev()->setNext(node->getNext());
+    }
+    if (node->getNext() != nullptr){
+      node->getNext()->setPrev(node->getPrev());
+    }
+}
+
+#endif
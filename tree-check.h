@@ -0,0 +1,316 @@
+#ifndef TREE_CHECK_H
+#define TREE_CHECK_H
+
+#include <vector>
+#include <atomic>
+#include <climits>
+#include <cstdlib>
+#include <algorithm>
+#include "work-pool.h"
+
+/**
+* The structural checks validate() can run, as bits to be or-ed together.
+*/
+enum TreeCheck
+{
+    CHECK_EQUAL_PATHS = 1,      // every leaf at the same depth (equalPaths)
+    CHECK_HEIGHT_BALANCE = 2,   // subtree heights differ by at most 1 (isBalanced)
+    CHECK_ORDER = 4,            // in-order keys strictly increasing
+    CHECK_BALANCE_FIELD = 8     // stored AVL balance_ matches the real heights
+};
+
+/**
+* Outcome of validate(). failed holds the TreeCheck bit that was violated
+* first (0 if ok). height is only meaningful when ok is true.
+*/
+struct TreeCheckResult
+{
+    bool ok;
+    unsigned failed;
+    int height;
+};
+
+/**
+* Shape of one subtree as reported back to its parent. Leaf depths are
+* counted in nodes from the subtree's root; a subtree without leaves (the
+* empty one) has minLeaf = INT_MAX and maxLeaf = 0.
+*/
+struct SubtreeShape
+{
+    int height;
+    int minLeaf;
+    int maxLeaf;
+};
+
+/**
+* Runs any combination of TreeChecks over a tree in one pass. The top few
+* levels are expanded on the calling thread until there are several
+* subtrees per worker; each of those subtrees is then walked (iteratively,
+* post-order) as a task on a WorkStealingPool, and the top levels are
+* combined from the task results at the end. The first violation found by
+* any task cancels the rest.
+*
+* NodeT is Node<Key, Value> or a subclass. balanceFn, if given, is asked
+* whether a node's stored balance agrees with height(right) - height(left).
+*/
+template<typename NodeT, typename Key>
+class TreeChecker
+{
+public:
+    typedef bool (*BalanceFn)(const NodeT* node, int diff);
+
+    TreeChecker(unsigned checks, BalanceFn balanceFn = nullptr);
+    TreeCheckResult run(NodeT* root, WorkStealingPool& pool);
+
+protected:
+    struct Frame
+    {
+        NodeT* node;
+        const Key* lo;
+        const Key* hi;
+        int state;
+    };
+
+    struct Item
+    {
+        NodeT* node;
+        const Key* lo;
+        const Key* hi;
+        int left;      // slot of the left child, -1 if none
+        int right;
+        bool top;      // combined at the end rather than walked by a task
+    };
+
+    void fail(unsigned check);
+    bool cancelled() const;
+    bool checkOrder(const NodeT* node, const Key* lo, const Key* hi);
+    SubtreeShape combine(const NodeT* node, const SubtreeShape& l, const SubtreeShape& r);
+    SubtreeShape walk(NodeT* root, const Key* lo, const Key* hi);
+
+    static SubtreeShape emptyShape();
+
+    unsigned checks_;
+    BalanceFn balanceFn_;
+    std::atomic<unsigned> failed_;
+};
+
+template<typename NodeT, typename Key>
+TreeChecker<NodeT, Key>::TreeChecker(unsigned checks, BalanceFn balanceFn) :
+    checks_(checks), balanceFn_(balanceFn), failed_(0)
+{
+    if (balanceFn_ == nullptr){
+      checks_ &= ~(unsigned)CHECK_BALANCE_FIELD;
+    }
+}
+
+template<typename NodeT, typename Key>
+SubtreeShape TreeChecker<NodeT, Key>::emptyShape()
+{
+    SubtreeShape shape = { 0, INT_MAX, 0 };
+    return shape;
+}
+
+/**
+* Records the first violation; later ones are ignored.
+*/
+template<typename NodeT, typename Key>
+void TreeChecker<NodeT, Key>::fail(unsigned check)
+{
+    unsigned none = 0;
+    failed_.compare_exchange_strong(none, check);
+}
+
+template<typename NodeT, typename Key>
+bool TreeChecker<NodeT, Key>::cancelled() const
+{
+    return failed_.load(std::memory_order_relaxed) != 0;
+}
+
+/**
+* Keys must lie strictly between the bounds inherited from the ancestors.
+*/
+template<typename NodeT, typename Key>
+bool TreeChecker<NodeT, Key>::checkOrder(const NodeT* node, const Key* lo, const Key* hi)
+{
+    if (!(checks_ & CHECK_ORDER)){
+      return true;
+    }
+    if ((lo != nullptr && !(*lo < node->getKey())) || (hi != nullptr && !(node->getKey() < *hi))){
+      fail(CHECK_ORDER);
+      return false;
+    }
+    return true;
+}
+
+/**
+* Builds a node's shape from its children's and runs the height-based checks.
+*/
+template<typename NodeT, typename Key>
+SubtreeShape TreeChecker<NodeT, Key>::combine(const NodeT* node, const SubtreeShape& l, const SubtreeShape& r)
+{
+    SubtreeShape shape;
+    shape.height = std::max(l.height, r.height) + 1;
+    if (l.maxLeaf == 0 && r.maxLeaf == 0){ //leaf node
+      shape.minLeaf = 1;
+      shape.maxLeaf = 1;
+    }
+    else {
+      shape.minLeaf = std::min(l.minLeaf, r.minLeaf) + 1;
+      shape.maxLeaf = std::max(l.maxLeaf, r.maxLeaf) + 1;
+    }
+
+    int diff = r.height - l.height;
+    if ((checks_ & CHECK_HEIGHT_BALANCE) && std::abs(diff) > 1){
+      fail(CHECK_HEIGHT_BALANCE);
+    }
+    else if ((checks_ & CHECK_BALANCE_FIELD) && !balanceFn_(node, diff)){
+      fail(CHECK_BALANCE_FIELD);
+    }
+    else if ((checks_ & CHECK_EQUAL_PATHS) && shape.minLeaf != shape.maxLeaf){
+      fail(CHECK_EQUAL_PATHS);
+    }
+    return shape;
+}
+
+/**
+* Post-order walk of one subtree with an explicit stack. Each frame goes
+* through state 0 (check, descend left), 1 (descend right) and 2 (combine
+* the two child shapes sitting on top of the shape stack).
+*/
+template<typename NodeT, typename Key>
+SubtreeShape TreeChecker<NodeT, Key>::walk(NodeT* root, const Key* lo, const Key* hi)
+{
+    std::vector<Frame> frames;
+    std::vector<SubtreeShape> shapes;
+    frames.reserve(64);
+    shapes.reserve(64);
+    Frame first = { root, lo, hi, 0 };
+    frames.push_back(first);
+    size_t visited = 0;
+
+    while (!frames.empty()){
+      Frame& frame = frames.back();
+      NodeT* node = frame.node;
+      if (frame.state == 0){
+        if ((++visited & 1023) == 0 && cancelled()){
+          return emptyShape();
+        }
+        if (!checkOrder(node, frame.lo, frame.hi)){
+          return emptyShape();
+        }
+        frame.state = 1;
+        NodeT* left = static_cast<NodeT*>(node->getLeft());
+        if (left == nullptr){
+          shapes.push_back(emptyShape());
+        }
+        else {
+          Frame next = { left, frame.lo, &node->getKey(), 0 };
+          frames.push_back(next); //frame is invalid from here on
+        }
+      }
+      else if (frame.state == 1){
+        frame.state = 2;
+        NodeT* right = static_cast<NodeT*>(node->getRight());
+        if (right == nullptr){
+          shapes.push_back(emptyShape());
+        }
+        else {
+          Frame next = { right, &node->getKey(), frame.hi, 0 };
+          frames.push_back(next);
+        }
+      }
+      else {
+        SubtreeShape r = shapes.back();
+        shapes.pop_back();
+        SubtreeShape l = shapes.back();
+        shapes.pop_back();
+        shapes.push_back(combine(node, l, r));
+        frames.pop_back();
+        if (cancelled()){
+          return emptyShape();
+        }
+      }
+    }
+    return shapes.back();
+}
+
+template<typename NodeT, typename Key>
+TreeCheckResult TreeChecker<NodeT, Key>::run(NodeT* root, WorkStealingPool& pool)
+{
+    TreeCheckResult result = { true, 0, 0 };
+    if (root == nullptr){
+      return result;
+    }
+
+    // expand the top levels breadth-first until there are enough subtrees
+    // to keep every worker busy (and let stealing even out their sizes)
+    size_t wanted = pool.size() == 1 ? 1 : pool.size() * 8;
+    std::vector<Item> items;
+    Item rootItem = { root, nullptr, nullptr, -1, -1, false };
+    items.push_back(rootItem);
+    std::vector<int> frontier(1, 0);
+
+    while (frontier.size() < wanted && !cancelled()){
+      std::vector<int> next;
+      for (size_t i = 0; i < frontier.size(); i++){
+        int index = frontier[i];
+        Item item = items[index];
+        if (!checkOrder(item.node, item.lo, item.hi)){
+          break;
+        }
+        items[index].top = true;
+        NodeT* left = static_cast<NodeT*>(item.node->getLeft());
+        NodeT* right = static_cast<NodeT*>(item.node->getRight());
+        if (left != nullptr){
+          Item child = { left, item.lo, &item.node->getKey(), -1, -1, false };
+          items[index].left = (int)items.size();
+          next.push_back((int)items.size());
+          items.push_back(child);
+        }
+        if (right != nullptr){
+          Item child = { right, &item.node->getKey(), item.hi, -1, -1, false };
+          items[index].right = (int)items.size();
+          next.push_back((int)items.size());
+          items.push_back(child);
+        }
+      }
+      if (next.empty()){
+        break;
+      }
+      frontier.swap(next);
+    }
+
+    std::vector<SubtreeShape> shapes(items.size(), emptyShape());
+    std::vector<WorkStealingPool::Task> tasks;
+    for (size_t i = 0; i < items.size(); i++){
+      if (!items[i].top){
+        tasks.push_back([this, &items, &shapes, i]() {
+          if (!cancelled()){
+            shapes[i] = walk(items[i].node, items[i].lo, items[i].hi);
+          }
+        });
+      }
+    }
+    if (tasks.size() == 1){
+      tasks[0]();
+    }
+    else {
+      pool.run(tasks);
+    }
+
+    // children always come after their parents in items
+    for (size_t i = items.size(); i-- > 0 && !cancelled(); ){
+      if (items[i].top){
+        SubtreeShape l = items[i].left < 0 ? emptyShape() : shapes[items[i].left];
+        SubtreeShape r = items[i].right < 0 ? emptyShape() : shapes[items[i].right];
+        shapes[i] = combine(items[i].node, l, r);
+      }
+    }
+
+    result.failed = failed_.load();
+    result.ok = result.failed == 0;
+    result.height = result.ok ? shapes[0].height : 0;
+    return result;
+}
+
+#endif
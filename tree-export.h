@@ -0,0 +1,408 @@
+#ifndef TREE_EXPORT_H
+#define TREE_EXPORT_H
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <streambuf>
+#include <random>
+#include <type_traits>
+#include <cstring>
+
+/**
+* Output formats for exportTree().
+*
+* EXPORT_DOT writes a Graphviz digraph: one vertex per node labelled with
+* its key (and balance, where the tree keeps one) and one edge per child.
+*
+* EXPORT_JSON writes {"nodes": [...]}, one flat record per node in
+* pre-order: {"id", "parent", "side", "key", "depth"[, "balance"]}. The
+* root's parent is null. Flat records keep the writer streaming; nesting
+* would need the closing brackets of every open ancestor.
+*
+* Either way, a subtree left out by the depth limit or by sampling shows up
+* as a stub ("..." vertex, or a record with "omitted": true) so the reader
+* can tell a cut from a missing child.
+*/
+enum TreeExportFormat
+{
+    EXPORT_DOT,
+    EXPORT_JSON
+};
+
+/**
+* maxDepth: stop below this depth (root is depth 1); 0 for no limit.
+* sampleRate: fraction of the subtrees rooted at sampleDepth to keep; the
+* levels above sampleDepth are always written in full.
+*/
+struct TreeExportOptions
+{
+    TreeExportOptions() :
+        maxDepth(0), sampleDepth(8), sampleRate(1.0), seed(1)
+    {
+    }
+
+    int maxDepth;
+    int sampleDepth;
+    double sampleRate;
+    unsigned seed;
+};
+
+/**
+* A streambuf that appends everything written to it to a string, for
+* formatting keys with operator<<. (This header avoids <sstream>: it is
+* included from bst.h, which some test harnesses include after
+* "#define private public", and libstdc++'s <sstream> does not build
+* under that.)
+*/
+class StringSink : public std::streambuf
+{
+public:
+    std::string text;
+
+protected:
+    virtual int_type overflow(int_type c)
+    {
+      if (!traits_type::eq_int_type(c, traits_type::eof())){
+        text.push_back(traits_type::to_char_type(c));
+      }
+      return traits_type::not_eof(c);
+    }
+    virtual std::streamsize xsputn(const char* s, std::streamsize n)
+    {
+      text.append(s, (size_t)n);
+      return n;
+    }
+};
+
+/**
+* Collects output in a fixed buffer and hands it to the stream in large
+* write() calls, so the per-node cost is a few memcpys rather than a chain
+* of formatted operator<< calls. Integral values are formatted by hand;
+* anything else goes through operator<< once.
+*/
+class TreeWriter
+{
+public:
+    explicit TreeWriter(std::ostream& out, size_t capacity = 1 << 16);
+    ~TreeWriter();
+
+    void put(char c);
+    void put(const char* s);
+    void put(const std::string& s);
+    void putQuoted(const std::string& s, bool json);
+    void putInt(long long value);
+    void putUnsigned(unsigned long long value);
+    void flush();
+
+    // keys: numbers stay bare in JSON, everything else (including char) is
+    // printed with operator<< and quoted
+    template<typename T>
+    void putKey(const T& key, bool json);
+
+private:
+    TreeWriter(const TreeWriter&);
+    TreeWriter& operator=(const TreeWriter&);
+
+    template<typename T>
+    void putKey(const T& key, bool json, std::true_type integral);
+    template<typename T>
+    void putKey(const T& key, bool json, std::false_type integral);
+
+    std::ostream& out_;
+    std::vector<char> buffer_;
+    size_t used_;
+    StringSink scratchBuf_;
+    std::ostream scratch_;
+};
+
+inline TreeWriter::TreeWriter(std::ostream& out, size_t capacity) :
+    out_(out), buffer_(capacity < 64 ? 64 : capacity), used_(0), scratch_(&scratchBuf_)
+{
+
+}
+
+inline TreeWriter::~TreeWriter()
+{
+    flush();
+}
+
+inline void TreeWriter::flush()
+{
+    if (used_ > 0){
+      out_.write(&buffer_[0], used_);
+      used_ = 0;
+    }
+}
+
+inline void TreeWriter::put(char c)
+{
+    if (used_ == buffer_.size()){
+      flush();
+    }
+    buffer_[used_++] = c;
+}
+
+inline void TreeWriter::put(const char* s)
+{
+    size_t length = std::strlen(s);
+    if (used_ + length > buffer_.size()){
+      flush();
+    }
+    if (length > buffer_.size()){
+      out_.write(s, length);
+      return;
+    }
+    std::memcpy(&buffer_[used_], s, length);
+    used_ += length;
+}
+
+inline void TreeWriter::put(const std::string& s)
+{
+    put(s.c_str());
+}
+
+/**
+* Writes s as a double-quoted string with quotes and backslashes escaped.
+* Control characters become \u escapes in JSON; DOT has no such escape,
+* so there a newline becomes its \n line break and the rest a space.
+*/
+inline void TreeWriter::putQuoted(const std::string& s, bool json)
+{
+    static const char hex[] = "0123456789abcdef";
+    put('"');
+    for (size_t i = 0; i < s.size(); i++){
+      unsigned char c = (unsigned char)s[i];
+      if (c == '"' || c == '\\'){
+        put('\\');
+        put((char)c);
+      }
+      else if (c < 0x20 && json){
+        put("\\u00");
+        put(hex[c >> 4]);
+        put(hex[c & 15]);
+      }
+      else if (c < 0x20){
+        put(c == '\n' ? "\\n" : " ");
+      }
+      else {
+        put((char)c);
+      }
+    }
+    put('"');
+}
+
+inline void TreeWriter::putUnsigned(unsigned long long value)
+{
+    char digits[24];
+    int count = 0;
+    do {
+      digits[count++] = (char)('0' + value % 10);
+      value /= 10;
+    } while (value != 0);
+    while (count > 0){
+      put(digits[--count]);
+    }
+}
+
+inline void TreeWriter::putInt(long long value)
+{
+    if (value < 0){
+      put('-');
+      putUnsigned(0ULL - (unsigned long long)value);
+    }
+    else {
+      putUnsigned((unsigned long long)value);
+    }
+}
+
+template<typename T>
+void TreeWriter::putKey(const T& key, bool json)
+{
+    putKey(key, json, std::integral_constant<bool,
+        std::is_integral<T>::value && !std::is_same<T, char>::value && !std::is_same<T, bool>::value>());
+}
+
+template<typename T>
+void TreeWriter::putKey(const T& key, bool json, std::true_type)
+{
+    if (!json){
+      put('"');
+    }
+    if (std::is_signed<T>::value){
+      putInt((long long)key);
+    }
+    else {
+      putUnsigned((unsigned long long)key);
+    }
+    if (!json){
+      put('"');
+    }
+}
+
+template<typename T>
+void TreeWriter::putKey(const T& key, bool json, std::false_type)
+{
+    scratchBuf_.text.clear();
+    scratch_ << key;
+    if (json && std::is_floating_point<T>::value){
+      put(scratchBuf_.text);
+    }
+    else {
+      putQuoted(scratchBuf_.text, json);
+    }
+}
+
+/**
+* Streams a tree out as DOT or JSON in one iterative pre-order walk. Memory
+* is the writer's buffer plus an explicit stack of at most two entries per
+* level, so O(height) whatever the size of the tree.
+*
+* NodeT is Node<Key, Value> or a subclass. balanceFn, if given, supplies
+* each node's stored balance for the output.
+*/
+template<typename NodeT>
+class TreeExporter
+{
+public:
+    typedef int (*BalanceFn)(const NodeT* node);
+
+    TreeExporter(const TreeExportOptions& options, BalanceFn balanceFn = nullptr);
+    void run(NodeT* root, std::ostream& out, TreeExportFormat format);
+
+protected:
+    struct Frame
+    {
+        NodeT* node;        // nullptr for an omitted subtree
+        long long parent;   // id, -1 for the root
+        int depth;
+        char side;          // 'L', 'R', or 0 for the root
+    };
+
+    void writeNode(TreeWriter& writer, TreeExportFormat format, const Frame& frame, unsigned long long id, bool first);
+    bool keepChild(int childDepth);
+
+    TreeExportOptions options_;
+    BalanceFn balanceFn_;
+    std::mt19937 gen_;
+};
+
+template<typename NodeT>
+TreeExporter<NodeT>::TreeExporter(const TreeExportOptions& options, BalanceFn balanceFn) :
+    options_(options), balanceFn_(balanceFn), gen_(options.seed)
+{
+
+}
+
+/**
+* False if the child at childDepth falls past the depth limit, or is the
+* root of a subtree that sampling drops.
+*/
+template<typename NodeT>
+bool TreeExporter<NodeT>::keepChild(int childDepth)
+{
+    if (options_.maxDepth > 0 && childDepth > options_.maxDepth){
+      return false;
+    }
+    if (childDepth == options_.sampleDepth && options_.sampleRate < 1.0){
+      return std::uniform_real_distribution<double>(0.0, 1.0)(gen_) < options_.sampleRate;
+    }
+    return true;
+}
+
+template<typename NodeT>
+void TreeExporter<NodeT>::writeNode(TreeWriter& writer, TreeExportFormat format, const Frame& frame,
+                                    unsigned long long id, bool first)
+{
+    if (format == EXPORT_DOT){
+      writer.put("  n");
+      writer.putUnsigned(id);
+      if (frame.node == nullptr){
+        writer.put(" [label=\"...\", shape=plaintext];\n");
+      }
+      else {
+        writer.put(" [label=");
+        writer.putKey(frame.node->getKey(), false);
+        if (balanceFn_ != nullptr){
+          writer.put(", xlabel=\"");
+          writer.putInt(balanceFn_(frame.node));
+          writer.put('"');
+        }
+        writer.put("];\n");
+      }
+      if (frame.parent >= 0){
+        writer.put("  n");
+        writer.putInt(frame.parent);
+        writer.put(frame.side == 'L' ? ":sw -> n" : ":se -> n");
+        writer.putUnsigned(id);
+        writer.put(frame.node == nullptr ? " [style=dashed];\n" : ";\n");
+      }
+      return;
+    }
+
+    writer.put(first ? "\n  {\"id\": " : ",\n  {\"id\": ");
+    writer.putUnsigned(id);
+    writer.put(", \"parent\": ");
+    if (frame.parent < 0){
+      writer.put("null");
+    }
+    else {
+      writer.putInt(frame.parent);
+    }
+    if (frame.side != 0){
+      writer.put(frame.side == 'L' ? ", \"side\": \"L\"" : ", \"side\": \"R\"");
+    }
+    writer.put(", \"depth\": ");
+    writer.putInt(frame.depth);
+    if (frame.node == nullptr){
+      writer.put(", \"omitted\": true}");
+      return;
+    }
+    writer.put(", \"key\": ");
+    writer.putKey(frame.node->getKey(), true);
+    if (balanceFn_ != nullptr){
+      writer.put(", \"balance\": ");
+      writer.putInt(balanceFn_(frame.node));
+    }
+    writer.put('}');
+}
+
+template<typename NodeT>
+void TreeExporter<NodeT>::run(NodeT* root, std::ostream& out, TreeExportFormat format)
+{
+    TreeWriter writer(out);
+    writer.put(format == EXPORT_DOT ? "digraph tree {\n  node [shape=box];\n" : "{\"nodes\": [");
+
+    std::vector<Frame> stack;
+    if (root != nullptr){
+      Frame first = { root, -1, 1, 0 };
+      stack.push_back(first);
+    }
+    unsigned long long nextId = 0;
+    while (!stack.empty()){
+      Frame frame = stack.back();
+      stack.pop_back();
+      unsigned long long id = nextId++;
+      writeNode(writer, format, frame, id, id == 0);
+      if (frame.node == nullptr){
+        continue;
+      }
+
+      // right first so the left subtree is written first
+      NodeT* children[2] = { static_cast<NodeT*>(frame.node->getRight()),
+                             static_cast<NodeT*>(frame.node->getLeft()) };
+      for (int i = 0; i < 2; i++){
+        if (children[i] != nullptr){
+          Frame child = { children[i], (long long)id, frame.depth + 1, i == 0 ? 'R' : 'L' };
+          if (!keepChild(child.depth)){
+            child.node = nullptr;
+          }
+          stack.push_back(child);
+        }
+      }
+    }
+
+    writer.put(format == EXPORT_DOT ? "}\n" : "\n]}\n");
+}
+
+#endif
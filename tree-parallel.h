@@ -0,0 +1,229 @@
+#ifndef TREE_PARALLEL_H
+#define TREE_PARALLEL_H
+
+#include <vector>
+#include "work-pool.h"
+
+/**
+* Splits a BinarySearchTree (or a key range of one) into chunks that are
+* contiguous in key order, for parallel_for_each and parallel_reduce.
+*
+* The top levels are expanded until there are several subtrees per worker:
+* each expanded node becomes a single-node entry between the entries for
+* its left and right subtrees, so the entry list stays in key order. A
+* chunk is one subtree entry plus the single nodes up to the next subtree,
+* and is walked in order with an explicit stack. Subtrees that lie wholly
+* outside [lo, hi) are dropped during the expansion and pruned during the
+* walks, so a narrow range only touches O(height + range) nodes.
+*/
+template<typename Key, typename Value>
+class TreePartition
+{
+public:
+    TreePartition(const BinarySearchTree<Key, Value>& tree, const Key* lo, const Key* hi, unsigned workers);
+
+    size_t size() const;
+    // calls fn(item) on every item of chunk in key order
+    template<typename Fn>
+    void visit(size_t chunk, Fn& fn) const;
+
+protected:
+    struct Entry
+    {
+        Node<Key, Value>* node;
+        bool whole;     // the node's subtree, or just the node itself
+    };
+
+    bool inRange(const Key& key) const;
+    template<typename Fn>
+    void walk(Node<Key, Value>* root, Fn& fn) const;
+
+    const Key* lo_;     // inclusive, nullptr for unbounded
+    const Key* hi_;     // exclusive, nullptr for unbounded
+    std::vector<Entry> entries_;
+    std::vector<size_t> chunks_;    // first entry of each chunk, then entries_.size()
+};
+
+template<typename Key, typename Value>
+TreePartition<Key, Value>::TreePartition(const BinarySearchTree<Key, Value>& tree, const Key* lo, const Key* hi,
+                                         unsigned workers) :
+    lo_(lo), hi_(hi)
+{
+    size_t wanted = workers <= 1 ? 1 : workers * 8;
+    if (tree.root_ != nullptr){
+      Entry root = { tree.root_, true };
+      entries_.push_back(root);
+    }
+
+    // each pass replaces every subtree entry with its left subtree, the
+    // node itself and its right subtree (any of which may be dropped)
+    size_t subtrees = entries_.size();
+    while (subtrees > 0 && subtrees < wanted){
+      std::vector<Entry> next;
+      size_t nextSubtrees = 0;
+      for (size_t i = 0; i < entries_.size(); i++){
+        Node<Key, Value>* node = entries_[i].node;
+        if (!entries_[i].whole){
+          next.push_back(entries_[i]);
+          continue;
+        }
+        //left keys are all < node's key, right keys all > it
+        if (node->getLeft() != nullptr && (lo_ == nullptr || *lo_ < node->getKey())){
+          Entry left = { node->getLeft(), true };
+          next.push_back(left);
+          nextSubtrees++;
+        }
+        if (inRange(node->getKey())){
+          Entry self = { node, false };
+          next.push_back(self);
+        }
+        if (node->getRight() != nullptr && (hi_ == nullptr || node->getKey() < *hi_)){
+          Entry right = { node->getRight(), true };
+          next.push_back(right);
+          nextSubtrees++;
+        }
+      }
+      entries_.swap(next);
+      subtrees = nextSubtrees;
+    }
+
+    bool chunkHasSubtree = false;
+    for (size_t i = 0; i < entries_.size(); i++){
+      if (i == 0 || (entries_[i].whole && chunkHasSubtree)){
+        chunks_.push_back(i);
+        chunkHasSubtree = false;
+      }
+      chunkHasSubtree = chunkHasSubtree || entries_[i].whole;
+    }
+    chunks_.push_back(entries_.size());
+}
+
+template<typename Key, typename Value>
+size_t TreePartition<Key, Value>::size() const
+{
+    return chunks_.size() - 1;
+}
+
+template<typename Key, typename Value>
+bool TreePartition<Key, Value>::inRange(const Key& key) const
+{
+    return (lo_ == nullptr || !(key < *lo_)) && (hi_ == nullptr || key < *hi_);
+}
+
+template<typename Key, typename Value>
+template<typename Fn>
+void TreePartition<Key, Value>::visit(size_t chunk, Fn& fn) const
+{
+    for (size_t i = chunks_[chunk]; i < chunks_[chunk + 1]; i++){
+      if (entries_[i].whole){
+        walk(entries_[i].node, fn);
+      }
+      else {
+        fn(entries_[i].node->getItem());
+      }
+    }
+}
+
+/**
+* In-order walk of one subtree restricted to [lo, hi): the descent skips
+* left subtrees below lo, and the walk stops at the first key >= hi.
+*/
+template<typename Key, typename Value>
+template<typename Fn>
+void TreePartition<Key, Value>::walk(Node<Key, Value>* root, Fn& fn) const
+{
+    std::vector<Node<Key, Value>*> stack;
+    Node<Key, Value>* current = root;
+    while (current != nullptr || !stack.empty()){
+      while (current != nullptr){
+        if (lo_ != nullptr && current->getKey() < *lo_){
+          current = current->getRight();
+          continue;
+        }
+        stack.push_back(current);
+        current = (lo_ == nullptr || *lo_ < current->getKey()) ? current->getLeft() : nullptr;
+      }
+      if (stack.empty()){ //ran off the right of everything below lo
+        return;
+      }
+      Node<Key, Value>* node = stack.back();
+      stack.pop_back();
+      if (hi_ != nullptr && !(node->getKey() < *hi_)){
+        return;
+      }
+      fn(node->getItem());
+      current = node->getRight();
+    }
+}
+
+/**
+* Calls fn(item) for every item of the tree, on the pool's threads. Each
+* chunk's items are visited in key order by one thread, but chunks run
+* concurrently, so fn must be safe to call on different items at once.
+* Values may be modified in place through the pair's second.
+*/
+template<typename Key, typename Value, typename Fn>
+void parallel_for_each(BinarySearchTree<Key, Value>& tree, Fn fn, WorkStealingPool& pool)
+{
+    TreePartition<Key, Value> partition(tree, nullptr, nullptr, pool.size());
+    std::vector<WorkStealingPool::Task> tasks;
+    for (size_t i = 0; i < partition.size(); i++){
+      tasks.push_back([&partition, &fn, i]() {
+        partition.visit(i, fn);
+      });
+    }
+    pool.run(tasks);
+}
+
+template<typename Key, typename Value, typename Fn>
+void parallel_for_each(BinarySearchTree<Key, Value>& tree, Fn fn)
+{
+    parallel_for_each(tree, fn, WorkStealingPool::shared());
+}
+
+/**
+* Folds the values with keys in [lo, hi) into init with op, in parallel.
+* Every chunk folds its own values in key order and the chunk results are
+* folded into init in key order too, so op has to be associative but need
+* not be commutative (and needs no identity element). Values must convert
+* to T, and op is called as op(T, T).
+*/
+template<typename Key, typename Value, typename T, typename Op>
+T parallel_reduce(const BinarySearchTree<Key, Value>& tree, const Key& lo, const Key& hi, T init, Op op,
+                  WorkStealingPool& pool)
+{
+    TreePartition<Key, Value> partition(tree, &lo, &hi, pool.size());
+    std::vector<T> partials(partition.size(), init);
+    std::vector<char> found(partition.size(), 0);
+    std::vector<WorkStealingPool::Task> tasks;
+    for (size_t i = 0; i < partition.size(); i++){
+      tasks.push_back([&partition, &partials, &found, &op, i]() {
+        auto fold = [&partials, &found, &op, i](const std::pair<const Key, Value>& item) {
+          if (found[i]){
+            partials[i] = op(partials[i], item.second);
+          }
+          else {
+            partials[i] = item.second;
+            found[i] = 1;
+          }
+        };
+        partition.visit(i, fold);
+      });
+    }
+    pool.run(tasks);
+
+    for (size_t i = 0; i < partials.size(); i++){
+      if (found[i]){
+        init = op(init, partials[i]);
+      }
+    }
+    return init;
+}
+
+template<typename Key, typename Value, typename T, typename Op>
+T parallel_reduce(const BinarySearchTree<Key, Value>& tree, const Key& lo, const Key& hi, T init, Op op)
+{
+    return parallel_reduce(tree, lo, hi, init, op, WorkStealingPool::shared());
+}
+
+#endif
@@ -0,0 +1,186 @@
+#ifndef TREE_STATS_H
+#define TREE_STATS_H
+
+#include <vector>
+#include <map>
+#include <ostream>
+#include <random>
+#include <algorithm>
+#include <cmath>
+
+/**
+* Shape and size of a tree as reported by analyze(). Depths count nodes
+* from the root, so the root is at depth 1 and a node's depth is the number
+* of comparisons a successful find() makes to reach it.
+*
+* When sampled is true every count is an estimate (rounded), height is the
+* deepest path seen rather than the true height, and balanceFactors is
+* empty, since balance factors need whole subtrees.
+*/
+struct TreeStats
+{
+    bool sampled;
+    size_t samples;                         // random descents, 0 for a full pass
+    size_t nodes;
+    size_t leaves;
+    int height;
+    double avgSearchDepth;                  // mean node depth
+    std::map<int, size_t> leafDepths;       // leaf depth -> number of leaves
+    std::map<int, size_t> balanceFactors;   // height(right) - height(left) -> nodes
+    size_t nodeBytes;                       // sizeof one node
+    size_t memoryBytes;                     // nodes * nodeBytes + treeBytes
+
+    void writeJson(std::ostream& out) const;
+};
+
+/**
+* Writes the stats as one JSON object. Histogram keys are the depths or
+* balance factors, as strings.
+*/
+inline void TreeStats::writeJson(std::ostream& out) const
+{
+    out << "{\"sampled\": " << (sampled ? "true" : "false")
+        << ", \"samples\": " << samples
+        << ", \"nodes\": " << nodes
+        << ", \"leaves\": " << leaves
+        << ", \"height\": " << height
+        << ", \"avgSearchDepth\": " << avgSearchDepth
+        << ", \"leafDepths\": {";
+    for (std::map<int, size_t>::const_iterator it = leafDepths.begin(); it != leafDepths.end(); ++it){
+      out << (it == leafDepths.begin() ? "" : ", ") << "\"" << it->first << "\": " << it->second;
+    }
+    out << "}, \"balanceFactors\": {";
+    for (std::map<int, size_t>::const_iterator it = balanceFactors.begin(); it != balanceFactors.end(); ++it){
+      out << (it == balanceFactors.begin() ? "" : ", ") << "\"" << it->first << "\": " << it->second;
+    }
+    out << "}, \"nodeBytes\": " << nodeBytes
+        << ", \"memoryBytes\": " << memoryBytes << "}";
+}
+
+/**
+* Gathers every TreeStats field in one post-order walk with an explicit
+* stack (no recursion, so degenerate trees are fine). A node's height is
+* handed to its parent's frame when the node is finished, which is all the
+* balance factors need.
+*/
+template<typename NodeT>
+TreeStats collectTreeStats(NodeT* root, size_t nodeBytes, size_t treeBytes)
+{
+    struct Frame
+    {
+        NodeT* node;
+        int depth;
+        int leftHeight;
+        int rightHeight;
+        int state;      // 0: descend left, 1: descend right, 2: finish
+    };
+
+    TreeStats stats = TreeStats();
+    stats.nodeBytes = nodeBytes;
+    double depthSum = 0;
+
+    std::vector<Frame> frames;
+    if (root != nullptr){
+      Frame first = { root, 1, 0, 0, 0 };
+      frames.push_back(first);
+    }
+    while (!frames.empty()){
+      Frame& frame = frames.back();
+      NodeT* child = nullptr;
+      if (frame.state == 0){
+        frame.state = 1;
+        child = static_cast<NodeT*>(frame.node->getLeft());
+      }
+      else if (frame.state == 1){
+        frame.state = 2;
+        child = static_cast<NodeT*>(frame.node->getRight());
+      }
+      else {
+        int height = std::max(frame.leftHeight, frame.rightHeight) + 1;
+        stats.nodes++;
+        depthSum += frame.depth;
+        stats.height = std::max(stats.height, frame.depth);
+        stats.balanceFactors[frame.rightHeight - frame.leftHeight]++;
+        if (height == 1){
+          stats.leaves++;
+          stats.leafDepths[frame.depth]++;
+        }
+        frames.pop_back();
+        if (!frames.empty()){
+          Frame& parent = frames.back();
+          (parent.state == 1 ? parent.leftHeight : parent.rightHeight) = height;
+        }
+        continue;
+      }
+      if (child != nullptr){
+        Frame next = { child, frame.depth + 1, 0, 0, 0 };
+        frames.push_back(next); //frame is invalid from here on
+      }
+    }
+
+    stats.avgSearchDepth = stats.nodes == 0 ? 0 : depthSum / stats.nodes;
+    stats.memoryBytes = stats.nodes * nodeBytes + treeBytes;
+    return stats;
+}
+
+/**
+* Estimates the stats from random root-to-leaf descents instead of visiting
+* every node (Knuth's estimator): on a path that picks uniformly among the
+* children at each step, a node at depth d stands for the product of the
+* branching factors above it, which makes the node, leaf and depth sums
+* unbiased. Each descent costs O(height).
+*/
+template<typename NodeT>
+TreeStats sampleTreeStats(NodeT* root, size_t samples, unsigned seed, size_t nodeBytes, size_t treeBytes)
+{
+    TreeStats stats = TreeStats();
+    stats.sampled = true;
+    stats.samples = samples;
+    stats.nodeBytes = nodeBytes;
+    if (root == nullptr || samples == 0){
+      stats.memoryBytes = treeBytes;
+      return stats;
+    }
+
+    std::mt19937 gen(seed);
+    double nodes = 0;
+    double leaves = 0;
+    double depthSum = 0;
+    std::map<int, double> leafDepths;
+    for (size_t s = 0; s < samples; s++){
+      NodeT* node = root;
+      double weight = 1;
+      int depth = 1;
+      while (true){
+        nodes += weight;
+        depthSum += weight * depth;
+        NodeT* left = static_cast<NodeT*>(node->getLeft());
+        NodeT* right = static_cast<NodeT*>(node->getRight());
+        if (left == nullptr && right == nullptr){
+          leaves += weight;
+          leafDepths[depth] += weight;
+          break;
+        }
+        if (left != nullptr && right != nullptr){
+          weight *= 2;
+          node = (gen() & 1) ? right : left;
+        }
+        else {
+          node = left != nullptr ? left : right;
+        }
+        depth++;
+      }
+      stats.height = std::max(stats.height, depth);
+    }
+
+    stats.nodes = (size_t)std::llround(nodes / samples);
+    stats.leaves = (size_t)std::llround(leaves / samples);
+    stats.avgSearchDepth = depthSum / nodes;
+    for (std::map<int, double>::const_iterator it = leafDepths.begin(); it != leafDepths.end(); ++it){
+      stats.leafDepths[it->first] = (size_t)std::llround(it->second / samples);
+    }
+    stats.memoryBytes = stats.nodes * nodeBytes + treeBytes;
+    return stats;
+}
+
+#endif
@@ -0,0 +1,192 @@
+#ifndef WORK_POOL_H
+#define WORK_POOL_H
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+
+/**
+* A small fork-join thread pool. run() deals a batch of tasks out to
+* per-worker deques; each worker takes from the back of its own deque and,
+* once that is empty, steals from the front of the others, so uneven tasks
+* (e.g. subtrees of different sizes) still keep every thread busy. The
+* calling thread works as worker 0 until the whole batch is done.
+*/
+class WorkStealingPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    explicit WorkStealingPool(unsigned threads = 0);
+    ~WorkStealingPool();
+
+    unsigned size() const;
+    void run(const std::vector<Task>& tasks);
+
+    // A process-wide pool with one worker per hardware thread.
+    static WorkStealingPool& shared();
+
+private:
+    struct Worker
+    {
+        std::mutex lock;
+        std::deque<const Task*> tasks;
+    };
+
+    WorkStealingPool(const WorkStealingPool&);
+    WorkStealingPool& operator=(const WorkStealingPool&);
+
+    void workerLoop(unsigned id);
+    bool runOne(unsigned id);
+
+    std::vector<std::unique_ptr<Worker> > workers_;
+    std::vector<std::thread> threads_;
+    std::mutex runLock_;      // one batch at a time
+    std::mutex stateLock_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    std::atomic<size_t> pending_;
+    unsigned generation_;
+    bool stop_;
+};
+
+/**
+* Starts threads - 1 background workers (0 means one per hardware thread).
+*/
+inline WorkStealingPool::WorkStealingPool(unsigned threads) :
+    pending_(0), generation_(0), stop_(false)
+{
+    if (threads == 0){
+      threads = std::thread::hardware_concurrency();
+    }
+    if (threads == 0){
+      threads = 1;
+    }
+    for (unsigned i = 0; i < threads; i++){
+      workers_.push_back(std::unique_ptr<Worker>(new Worker()));
+    }
+    for (unsigned i = 1; i < threads; i++){
+      threads_.push_back(std::thread(&WorkStealingPool::workerLoop, this, i));
+    }
+}
+
+inline WorkStealingPool::~WorkStealingPool()
+{
+    {
+      std::lock_guard<std::mutex> guard(stateLock_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (size_t i = 0; i < threads_.size(); i++){
+      threads_[i].join();
+    }
+}
+
+inline unsigned WorkStealingPool::size() const
+{
+    return (unsigned)workers_.size();
+}
+
+inline WorkStealingPool& WorkStealingPool::shared()
+{
+    static WorkStealingPool pool;
+    return pool;
+}
+
+/**
+* Runs every task once and returns when all of them have finished. The
+* tasks must stay alive for the duration of the call.
+*/
+inline void WorkStealingPool::run(const std::vector<Task>& tasks)
+{
+    if (tasks.empty()){
+      return;
+    }
+    std::lock_guard<std::mutex> batch(runLock_);
+
+    //the count must be in place before any task is visible: a worker
+    //still draining the previous batch can pick up a new task at once
+    {
+      std::lock_guard<std::mutex> guard(stateLock_);
+      pending_ = tasks.size();
+    }
+    for (size_t i = 0; i < tasks.size(); i++){
+      Worker& worker = *workers_[i % workers_.size()];
+      std::lock_guard<std::mutex> guard(worker.lock);
+      worker.tasks.push_back(&tasks[i]);
+    }
+    {
+      std::lock_guard<std::mutex> guard(stateLock_);
+      generation_++;
+    }
+    wake_.notify_all();
+
+    while (runOne(0)){
+    }
+
+    std::unique_lock<std::mutex> guard(stateLock_);
+    while (pending_ != 0){
+      done_.wait(guard);
+    }
+}
+
+/**
+* Pops a task from this worker's own deque, or steals one from another
+* worker, and runs it. Returns false once there is nothing left anywhere.
+*/
+inline bool WorkStealingPool::runOne(unsigned id)
+{
+    const Task* task = nullptr;
+    {
+      Worker& own = *workers_[id];
+      std::lock_guard<std::mutex> guard(own.lock);
+      if (!own.tasks.empty()){
+        task = own.tasks.back();
+        own.tasks.pop_back();
+      }
+    }
+    for (size_t i = 1; task == nullptr && i < workers_.size(); i++){
+      Worker& victim = *workers_[(id + i) % workers_.size()];
+      std::lock_guard<std::mutex> guard(victim.lock);
+      if (!victim.tasks.empty()){
+        task = victim.tasks.front();
+        victim.tasks.pop_front();
+      }
+    }
+    if (task == nullptr){
+      return false;
+    }
+
+    (*task)();
+    if (--pending_ == 0){
+      std::lock_guard<std::mutex> guard(stateLock_);
+      done_.notify_all();
+    }
+    return true;
+}
+
+inline void WorkStealingPool::workerLoop(unsigned id)
+{
+    unsigned seen = 0;
+    while (true){
+      {
+        std::unique_lock<std::mutex> guard(stateLock_);
+        while (!stop_ && generation_ == seen){
+          wake_.wait(guard);
+        }
+        if (stop_){
+          return;
+        }
+        seen = generation_;
+      }
+      while (runOne(id)){
+      }
+    }
+}
+
+#endif